@@ -11,6 +11,18 @@ import logging
 KERNEL_TEST_EXTRAS = {
     'basic/probe_memory': {
         'CFLAGS': [ '-DKERNEL_TEST_PROBE_MEMORY_MAINMEM_SIZE_KB={mainmem_size}']
+    },
+    'sync/mutex_stats': {
+        'CFLAGS': [ '-DKERNEL_LOCK_STATS' ]
+    },
+    'thread/fair_share': {
+        'CFLAGS': [ '-DKERNEL_SCHED_FAIR' ]
+    },
+    'trace/basic': {
+        'CFLAGS': [ '-DKERNEL_TRACE' ]
+    },
+    'printk/buffered': {
+        'CFLAGS': [ '-DKERNEL_PRINTK_BUFFERED' ]
     }
 }
 
@@ -109,6 +121,30 @@ def main(argv):
         action='store_true',
         help='Build kernel in debug mode.'
     )
+    args.add_argument('--lock-stats',
+        default=False,
+        dest='lock_stats',
+        action='store_true',
+        help='Collect lock-hold histograms of mutexes.'
+    )
+    args.add_argument('--fair-scheduler',
+        default=False,
+        dest='fair_scheduler',
+        action='store_true',
+        help='Order ready threads by used processor time instead of round-robin.'
+    )
+    args.add_argument('--trace',
+        default=False,
+        dest='trace',
+        action='store_true',
+        help='Record scheduler events into in-memory trace buffer.'
+    )
+    args.add_argument('--buffered-printk',
+        default=False,
+        dest='buffered_printk',
+        action='store_true',
+        help='Buffer console output and write it from a low-priority thread.'
+    )
     args.add_argument('--kernel-test',
         default=None,
         dest='kernel_test',
@@ -183,6 +219,14 @@ def main(argv):
         kernel_extra_cflags = []
         if config.debug:
             kernel_extra_cflags.append('-DKERNEL_DEBUG')
+        if config.lock_stats:
+            kernel_extra_cflags.append('-DKERNEL_LOCK_STATS')
+        if config.fair_scheduler:
+            kernel_extra_cflags.append('-DKERNEL_SCHED_FAIR')
+        if config.trace:
+            kernel_extra_cflags.append('-DKERNEL_TRACE')
+        if config.buffered_printk:
+            kernel_extra_cflags.append('-DKERNEL_PRINTK_BUFFERED')
         if not (config.kernel_test is None):
             kernel_test_sources = 'tests/{}/test.c'.format(config.kernel_test)
             kernel_extra_cflags.append('-DKERNEL_TEST')
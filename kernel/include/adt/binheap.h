@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#ifndef _ADT_BINHEAP_H
+#define _ADT_BINHEAP_H
+
+#include <adt/list.h>
+#include <debug.h>
+#include <types.h>
+
+/*
+ * A binary min-heap of nodes embedded inside the item type.
+ *
+ * The heap itself is an array of node pointers provided by the caller
+ * (as with the rings in adt/ring.h, nothing is allocated). Each node
+ * remembers its position in the array so that any item can be removed
+ * or re-positioned after its key changed in O(log n).
+ *
+ * typedef struct my_timer {
+ *     uint32_t deadline;
+ *     binheap_node_t my_heap_node;
+ * } my_timer_t;
+ *
+ * static bool my_less(const binheap_node_t* a, const binheap_node_t* b) {
+ *     return binheap_item(a, my_timer_t, my_heap_node)->deadline
+ *             < binheap_item(b, my_timer_t, my_heap_node)->deadline;
+ * }
+ *
+ * binheap_node_t* slots[64];
+ * binheap_t heap;
+ * binheap_init(&heap, slots, 64, my_less);
+ * binheap_insert(&heap, &timer->my_heap_node);
+ * my_timer_t* first = binheap_item(binheap_pop(&heap), my_timer_t, my_heap_node);
+ */
+
+/** Get the item containing given heap node. */
+#define binheap_item(node, type, member) \
+    list_container_of(node, type, member)
+
+typedef struct {
+    /** Position in the heap array. */
+    size_t index;
+} binheap_node_t;
+
+/** Strict ordering of the nodes (the smallest one is on the top). */
+typedef bool (*binheap_less_func_t)(const binheap_node_t* a, const binheap_node_t* b);
+
+typedef struct {
+    binheap_node_t** slots;
+    size_t capacity;
+    size_t size;
+    binheap_less_func_t less;
+} binheap_t;
+
+/** Initialize an empty heap.
+ *
+ * @param heap Heap to initialize.
+ * @param slots Storage for the node pointers.
+ * @param capacity Number of slots.
+ * @param less Function ordering the nodes.
+ */
+static inline void binheap_init(binheap_t* heap, binheap_node_t** slots,
+        size_t capacity, binheap_less_func_t less) {
+    assert(heap != NULL);
+    assert(less != NULL);
+
+    heap->slots = slots;
+    heap->capacity = capacity;
+    heap->size = 0;
+    heap->less = less;
+}
+
+static inline size_t binheap_get_size(binheap_t* heap) {
+    return heap->size;
+}
+
+static inline bool binheap_is_empty(binheap_t* heap) {
+    return heap->size == 0;
+}
+
+/** Put a node to given slot (and let it know). */
+static inline void binheap_place(binheap_t* heap, size_t index,
+        binheap_node_t* node) {
+    heap->slots[index] = node;
+    node->index = index;
+}
+
+/** Move a node towards the root while it is smaller than its parent. */
+static inline void binheap_sift_up(binheap_t* heap, size_t index) {
+    binheap_node_t* node = heap->slots[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!heap->less(node, heap->slots[parent])) {
+            break;
+        }
+        binheap_place(heap, index, heap->slots[parent]);
+        index = parent;
+    }
+    binheap_place(heap, index, node);
+}
+
+/** Move a node towards the leaves while a child is smaller. */
+static inline void binheap_sift_down(binheap_t* heap, size_t index) {
+    binheap_node_t* node = heap->slots[index];
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= heap->size) {
+            break;
+        }
+        if ((child + 1 < heap->size)
+                && heap->less(heap->slots[child + 1], heap->slots[child])) {
+            child++;
+        }
+        if (!heap->less(heap->slots[child], node)) {
+            break;
+        }
+        binheap_place(heap, index, heap->slots[child]);
+        index = child;
+    }
+    binheap_place(heap, index, node);
+}
+
+/** Insert a node.
+ *
+ * @param heap Heap to insert to.
+ * @param node Node to insert.
+ * @return Whether the node was inserted (false when the heap is full).
+ */
+static inline bool binheap_insert(binheap_t* heap, binheap_node_t* node) {
+    assert(heap != NULL);
+    assert(node != NULL);
+
+    if (heap->size == heap->capacity) {
+        return false;
+    }
+    heap->slots[heap->size] = node;
+    heap->size++;
+    binheap_sift_up(heap, heap->size - 1);
+    return true;
+}
+
+/** Get the smallest node without removing it (NULL for an empty heap). */
+static inline binheap_node_t* binheap_peek(binheap_t* heap) {
+    return (heap->size == 0) ? NULL : heap->slots[0];
+}
+
+/** Remove any node from the heap.
+ *
+ * @param heap Heap the node is in.
+ * @param node Node to remove.
+ */
+static inline void binheap_remove(binheap_t* heap, binheap_node_t* node) {
+    size_t index = node->index;
+    assert(index < heap->size);
+    assert(heap->slots[index] == node);
+
+    heap->size--;
+    if (index == heap->size) {
+        return;
+    }
+
+    // The last node fills the hole and may need to go either way.
+    binheap_place(heap, index, heap->slots[heap->size]);
+    if ((index > 0) && heap->less(heap->slots[index], heap->slots[(index - 1) / 2])) {
+        binheap_sift_up(heap, index);
+    } else {
+        binheap_sift_down(heap, index);
+    }
+}
+
+/** Remove the smallest node (NULL for an empty heap). */
+static inline binheap_node_t* binheap_pop(binheap_t* heap) {
+    binheap_node_t* node = binheap_peek(heap);
+    if (node != NULL) {
+        binheap_remove(heap, node);
+    }
+    return node;
+}
+
+/** Restore the heap order after key of the node changed.
+ *
+ * @param heap Heap the node is in.
+ * @param node Node whose key was changed.
+ */
+static inline void binheap_update(binheap_t* heap, binheap_node_t* node) {
+    size_t index = node->index;
+    assert(index < heap->size);
+
+    if ((index > 0) && heap->less(node, heap->slots[(index - 1) / 2])) {
+        binheap_sift_up(heap, index);
+    } else {
+        binheap_sift_down(heap, index);
+    }
+}
+
+#endif
@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#ifndef _ADT_HASH_TABLE_H
+#define _ADT_HASH_TABLE_H
+
+#include <adt/list.h>
+#include <debug.h>
+#include <types.h>
+
+/*
+ * A hash table with separate chaining whose items are linked into the
+ * buckets through an embedded link_t (see adt/list.h).
+ *
+ * The bucket array is provided by the caller, its size must be a power
+ * of two. Nothing is allocated by the table itself: when the table grows
+ * too full (see hash_table_needs_resize), the caller may provide a bigger
+ * array to hash_table_resize() and release the old one.
+ *
+ * typedef struct my_item {
+ *     void* owner;
+ *     link_t my_hash_link;
+ * } my_item_t;
+ *
+ * static uint32_t my_hash(const link_t* link) {
+ *     return hash_pointer(list_item(link, my_item_t, my_hash_link)->owner);
+ * }
+ *
+ * static uint32_t my_key_hash(const void* key) {
+ *     return hash_pointer(key);
+ * }
+ *
+ * static bool my_key_equal(const void* key, const link_t* link) {
+ *     return list_item(link, my_item_t, my_hash_link)->owner == key;
+ * }
+ *
+ * static const hash_table_ops_t my_ops = { my_hash, my_key_hash, my_key_equal };
+ *
+ * list_t buckets[64];
+ * hash_table_t table;
+ * hash_table_init(&table, buckets, 64, &my_ops);
+ * hash_table_insert(&table, &item->my_hash_link);
+ * link_t* link = hash_table_find(&table, owner);
+ *
+ * The hash functions do not need to spread the values themselves, the
+ * table mixes them with Fibonacci hashing (multiplication by 2^32 / phi)
+ * and uses the top bits as the bucket index.
+ */
+
+/** Multiplier for Fibonacci hashing (2^32 divided by the golden ratio). */
+#define HASH_TABLE_GOLDEN_RATIO 0x9E3779B9U
+
+/** Average number of items per bucket above which resize is advised. */
+#define HASH_TABLE_MAX_LOAD 2
+
+/** Iterate over all items of the table (in no particular order).
+ *
+ * The current item must not be removed inside the loop and break only
+ * leaves the current bucket.
+ *
+ * @param table    The table to iterate over (pointer).
+ * @param type     The type of the structure the link is embedded in.
+ * @param member   The name of the link member in the structure.
+ * @param iterator The name of the iterator to declare.
+ */
+#define hash_table_foreach(table, type, member, iterator) \
+    for (size_t _bucket = 0; _bucket < (table)->bucket_count; _bucket++) \
+        list_foreach((table)->buckets[_bucket], type, member, iterator)
+
+/** Hash of the item the link is embedded in. */
+typedef uint32_t (*hash_table_hash_func_t)(const link_t* link);
+
+/** Hash of a key, must match hash_table_hash_func_t of equal items. */
+typedef uint32_t (*hash_table_key_hash_func_t)(const void* key);
+
+/** Whether the item the link is embedded in has given key. */
+typedef bool (*hash_table_key_equal_func_t)(const void* key, const link_t* link);
+
+typedef struct {
+    hash_table_hash_func_t hash;
+    hash_table_key_hash_func_t key_hash;
+    hash_table_key_equal_func_t key_equal;
+} hash_table_ops_t;
+
+typedef struct {
+    list_t* buckets;
+    size_t bucket_count;
+    /** Shift to get bucket index from the mixed hash (32 - log2(count)). */
+    unsigned int shift;
+    size_t size;
+    const hash_table_ops_t* ops;
+} hash_table_t;
+
+/** Hash a pointer key.
+ *
+ * The address itself is a good enough hash as the table mixes all its
+ * bits into the bucket index.
+ */
+static inline uint32_t hash_pointer(const void* ptr) {
+    return (uint32_t)(uintptr_t)ptr;
+}
+
+/** Attach bucket array to the table, all buckets are made empty. */
+static inline void hash_table_set_buckets(hash_table_t* table, list_t* buckets,
+        size_t bucket_count) {
+    assert(buckets != NULL);
+    assert((bucket_count > 0) && ((bucket_count & (bucket_count - 1)) == 0));
+
+    table->buckets = buckets;
+    table->bucket_count = bucket_count;
+    table->shift = 32;
+    for (size_t count = bucket_count; count > 1; count >>= 1) {
+        table->shift--;
+    }
+    for (size_t i = 0; i < bucket_count; i++) {
+        list_init(&buckets[i]);
+    }
+}
+
+/** Initialize an empty table.
+ *
+ * @param table Table to initialize.
+ * @param buckets Storage for the buckets.
+ * @param bucket_count Number of buckets (power of two).
+ * @param ops Hashing and comparison functions.
+ */
+static inline void hash_table_init(hash_table_t* table, list_t* buckets,
+        size_t bucket_count, const hash_table_ops_t* ops) {
+    assert(table != NULL);
+    assert(ops != NULL);
+
+    hash_table_set_buckets(table, buckets, bucket_count);
+    table->size = 0;
+    table->ops = ops;
+}
+
+static inline size_t hash_table_get_size(hash_table_t* table) {
+    return table->size;
+}
+
+static inline bool hash_table_is_empty(hash_table_t* table) {
+    return table->size == 0;
+}
+
+/** Whether the chains are long enough that more buckets would help. */
+static inline bool hash_table_needs_resize(hash_table_t* table) {
+    return table->size > HASH_TABLE_MAX_LOAD * table->bucket_count;
+}
+
+/** Get the bucket for given hash. */
+static inline list_t* hash_table_bucket(hash_table_t* table, uint32_t hash) {
+    // Shift by 32 is undefined, single bucket is handled by masking.
+    uint32_t mixed = hash * HASH_TABLE_GOLDEN_RATIO;
+    size_t index = (mixed >> (table->shift & 31)) & (table->bucket_count - 1);
+    return &table->buckets[index];
+}
+
+/** Insert an item.
+ *
+ * Items with equal keys are allowed, lookups find the oldest one.
+ *
+ * @param table Table to insert to.
+ * @param link Link of the item (must not be in any list).
+ */
+static inline void hash_table_insert(hash_table_t* table, link_t* link) {
+    assert(table != NULL);
+    assert(link != NULL);
+
+    list_append(hash_table_bucket(table, table->ops->hash(link)), link);
+    table->size++;
+}
+
+/** Find an item with given key.
+ *
+ * @param table Table to search.
+ * @param key Key to look for.
+ * @return Link of the matching item or NULL.
+ */
+static inline link_t* hash_table_find(hash_table_t* table, const void* key) {
+    assert(table != NULL);
+
+    list_t* bucket = hash_table_bucket(table, table->ops->key_hash(key));
+    for (link_t* link = bucket->head.next; link != &bucket->head; link = link->next) {
+        if (table->ops->key_equal(key, link)) {
+            return link;
+        }
+    }
+    return NULL;
+}
+
+/** Remove an item from the table.
+ *
+ * @param table Table the item is in.
+ * @param link Link of the item to remove.
+ */
+static inline void hash_table_remove(hash_table_t* table, link_t* link) {
+    assert(table->size > 0);
+    assert(link_is_connected(link));
+
+    list_remove(link);
+    table->size--;
+}
+
+/** Remove an item with given key.
+ *
+ * @param table Table to remove from.
+ * @param key Key of the item.
+ * @return Link of the removed item or NULL if there was none.
+ */
+static inline link_t* hash_table_remove_key(hash_table_t* table, const void* key) {
+    link_t* link = hash_table_find(table, key);
+    if (link != NULL) {
+        hash_table_remove(table, link);
+    }
+    return link;
+}
+
+/** Move all items to a new bucket array.
+ *
+ * @param table Table to resize.
+ * @param buckets New storage for the buckets.
+ * @param bucket_count Number of new buckets (power of two).
+ * @return The previous bucket array (now unused).
+ */
+static inline list_t* hash_table_resize(hash_table_t* table, list_t* buckets,
+        size_t bucket_count) {
+    assert(table != NULL);
+
+    list_t* old_buckets = table->buckets;
+    size_t old_bucket_count = table->bucket_count;
+
+    hash_table_set_buckets(table, buckets, bucket_count);
+    for (size_t i = 0; i < old_bucket_count; i++) {
+        link_t* link;
+        while ((link = list_pop(&old_buckets[i])) != NULL) {
+            list_append(hash_table_bucket(table, table->ops->hash(link)), link);
+        }
+    }
+
+    return old_buckets;
+}
+
+#endif
@@ -182,6 +182,15 @@ static inline bool list_is_empty(list_t* list) {
     return (list->head.next == &list->head);
 }
 
+/** Count items in a list
+ *
+ * Walks the whole list, use counted_list_t when the size is needed often.
+ *
+ * @param list The list to examine.
+ *
+ * @return Number of items in the list.
+ *
+ */
 static inline size_t list_get_size(list_t* list) {
     size_t result = 0;
     for (link_t* link = list->head.next; link != &(list->head); link = link->next) {
@@ -311,4 +320,148 @@ static inline link_t* list_rotate(list_t* list) {
     return item;
 }
 
+/*
+ * A list that also keeps the number of its items so that the size is
+ * known in O(1). It wraps list_t and all items must be added and removed
+ * through the counted_list_* functions (iteration and list_item work
+ * on the inner list as usual):
+ *
+ * counted_list_t my_list;
+ * counted_list_init(&my_list);
+ * counted_list_append(&my_list, &item->my_list_link);
+ * counted_list_foreach (my_list, my_item_t, my_list_link, item) {
+ *     do_something_with(item);
+ * }
+ *
+ */
+
+/** Iterate over counted list members
+ *
+ * @see list_foreach
+ *
+ */
+#define counted_list_foreach(clist, type, member, iterator) \
+    list_foreach((clist).list, type, member, iterator)
+
+/** List with constant time size query
+ *
+ */
+typedef struct {
+    list_t list;
+    size_t size;
+} counted_list_t;
+
+/** Initialize an empty counted list
+ *
+ * @param clist The list to initialize.
+ *
+ */
+static inline void counted_list_init(counted_list_t* clist) {
+    assert(clist != NULL);
+
+    list_init(&clist->list);
+    clist->size = 0;
+}
+
+/** Get number of items in a counted list
+ *
+ * @param clist The list to examine.
+ *
+ * @return Number of items in the list.
+ *
+ */
+static inline size_t counted_list_get_size(counted_list_t* clist) {
+    assert(clist != NULL);
+
+    return clist->size;
+}
+
+/** Test whether a counted list is empty
+ *
+ * @param clist The list to examine.
+ *
+ * @return True if the list is empty.
+ *
+ */
+static inline bool counted_list_is_empty(counted_list_t* clist) {
+    assert(clist != NULL);
+
+    return clist->size == 0;
+}
+
+/** Prepend item to the counted list
+ *
+ * @param clist The list to prepend to.
+ * @param link The new item link.
+ *
+ */
+static inline void counted_list_prepend(counted_list_t* clist, link_t* link) {
+    list_prepend(&clist->list, link);
+    clist->size++;
+}
+
+/** Append item to the counted list
+ *
+ * @param clist The list to append to.
+ * @param link The new item link.
+ *
+ */
+static inline void counted_list_append(counted_list_t* clist, link_t* link) {
+    list_append(&clist->list, link);
+    clist->size++;
+}
+
+/** Add item after selected link of the counted list
+ *
+ * @param clist The list add_after is in.
+ * @param add_after Item (or the list head) to add after.
+ * @param item The new item link.
+ *
+ */
+static inline void counted_list_add(counted_list_t* clist, link_t* add_after,
+        link_t* item) {
+    list_add(add_after, item);
+    clist->size++;
+}
+
+/** Remove an item from the counted list
+ *
+ * @param clist The list the item is in.
+ * @param link The item link to remove (must be connected).
+ *
+ */
+static inline void counted_list_remove(counted_list_t* clist, link_t* link) {
+    assert(clist->size > 0);
+    assert(link_is_connected(link));
+
+    list_remove(link);
+    clist->size--;
+}
+
+/** Pop the first item from the counted list
+ *
+ * @param clist The list to pop from.
+ *
+ * @return The first item or NULL if the list is empty.
+ *
+ */
+static inline link_t* counted_list_pop(counted_list_t* clist) {
+    link_t* item = list_pop(&clist->list);
+    if (item != NULL) {
+        clist->size--;
+    }
+    return item;
+}
+
+/** Rotate the counted list by making its head into its tail
+ *
+ * @param clist The list to rotate.
+ *
+ * @return The rotated item.
+ *
+ */
+static inline link_t* counted_list_rotate(counted_list_t* clist) {
+    return list_rotate(&clist->list);
+}
+
 #endif
@@ -0,0 +1,412 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#ifndef _ADT_RBTREE_H
+#define _ADT_RBTREE_H
+
+#include <adt/list.h>
+#include <debug.h>
+#include <types.h>
+
+/*
+ * A red-black tree whose nodes are embedded inside the item type
+ * (in the same way as link_t of adt/list.h), nothing is ever allocated.
+ *
+ * typedef struct my_item {
+ *     int key;
+ *     rb_node_t my_tree_node;
+ * } my_item_t;
+ *
+ * Ordering is given by a comparison function passed to the insertion,
+ * lookups take a key and a function comparing the key with a node:
+ *
+ * static int my_compare(const rb_node_t* a, const rb_node_t* b) {
+ *     return rb_item(a, my_item_t, my_tree_node)->key
+ *             - rb_item(b, my_item_t, my_tree_node)->key;
+ * }
+ *
+ * static int my_compare_key(const void* key, const rb_node_t* node) {
+ *     return *(const int*)key - rb_item(node, my_item_t, my_tree_node)->key;
+ * }
+ *
+ * rb_tree_t tree;
+ * rb_tree_init(&tree);
+ * rb_tree_insert(&tree, &item->my_tree_node, my_compare);
+ * rb_node_t* node = rb_tree_find(&tree, &key, my_compare_key);
+ *
+ * Items with equal keys are allowed (a new one goes after the existing
+ * ones). Insertion, removal and lookup take O(log n), iteration with
+ * rb_tree_first() and rb_node_next() takes O(1) amortized per item.
+ */
+
+/** Get the item containing given tree node. */
+#define rb_item(node, type, member) \
+    list_container_of(node, type, member)
+
+/** Iterate over the tree in ascending order.
+ *
+ * The current item must not be removed inside the loop.
+ *
+ * @param tree     The tree to iterate over (pointer).
+ * @param type     The type of the structure the node is embedded in.
+ * @param member   The name of the node member in the structure.
+ * @param iterator The name of the iterator to declare.
+ */
+#define rb_tree_foreach(tree, type, member, iterator) \
+    for (type* iterator = NULL; iterator == NULL; iterator = (type*)1) \
+        for (rb_node_t* _node = rb_tree_first(tree); \
+                _node != NULL && (iterator = rb_item(_node, type, member), true); \
+                _node = rb_node_next(_node))
+
+typedef struct rb_node {
+    struct rb_node* parent;
+    struct rb_node* left;
+    struct rb_node* right;
+    bool red;
+} rb_node_t;
+
+typedef struct {
+    rb_node_t* root;
+} rb_tree_t;
+
+/** Compare two nodes, returns negative, zero or positive number. */
+typedef int (*rb_compare_func_t)(const rb_node_t* a, const rb_node_t* b);
+
+/** Compare a key with a node, returns negative, zero or positive number. */
+typedef int (*rb_compare_key_func_t)(const void* key, const rb_node_t* node);
+
+/** Initialize an empty tree.
+ *
+ * @param tree The tree to initialize.
+ */
+static inline void rb_tree_init(rb_tree_t* tree) {
+    assert(tree != NULL);
+
+    tree->root = NULL;
+}
+
+/** Test whether a tree is empty.
+ *
+ * @param tree The tree to examine.
+ */
+static inline bool rb_tree_is_empty(rb_tree_t* tree) {
+    assert(tree != NULL);
+
+    return tree->root == NULL;
+}
+
+/** Get the leftmost node of a subtree. */
+static inline rb_node_t* rb_node_leftmost(rb_node_t* node) {
+    while (node->left != NULL) {
+        node = node->left;
+    }
+    return node;
+}
+
+/** Get the rightmost node of a subtree. */
+static inline rb_node_t* rb_node_rightmost(rb_node_t* node) {
+    while (node->right != NULL) {
+        node = node->right;
+    }
+    return node;
+}
+
+/** Get the smallest node of the tree (NULL for an empty tree). */
+static inline rb_node_t* rb_tree_first(rb_tree_t* tree) {
+    return (tree->root == NULL) ? NULL : rb_node_leftmost(tree->root);
+}
+
+/** Get the biggest node of the tree (NULL for an empty tree). */
+static inline rb_node_t* rb_tree_last(rb_tree_t* tree) {
+    return (tree->root == NULL) ? NULL : rb_node_rightmost(tree->root);
+}
+
+/** Get the following node in ascending order (NULL after the last one). */
+static inline rb_node_t* rb_node_next(rb_node_t* node) {
+    if (node->right != NULL) {
+        return rb_node_leftmost(node->right);
+    }
+    while ((node->parent != NULL) && (node == node->parent->right)) {
+        node = node->parent;
+    }
+    return node->parent;
+}
+
+/** Get the preceding node in ascending order (NULL before the first one). */
+static inline rb_node_t* rb_node_prev(rb_node_t* node) {
+    if (node->left != NULL) {
+        return rb_node_rightmost(node->left);
+    }
+    while ((node->parent != NULL) && (node == node->parent->left)) {
+        node = node->parent;
+    }
+    return node->parent;
+}
+
+/** Find a node equal to the key.
+ *
+ * @param tree The tree to search.
+ * @param key Key to look for.
+ * @param compare Function comparing the key with a node.
+ * @return Matching node (any of them if there are more) or NULL.
+ */
+static inline rb_node_t* rb_tree_find(rb_tree_t* tree, const void* key,
+        rb_compare_key_func_t compare) {
+    rb_node_t* node = tree->root;
+    while (node != NULL) {
+        int result = compare(key, node);
+        if (result == 0) {
+            return node;
+        }
+        node = (result < 0) ? node->left : node->right;
+    }
+    return NULL;
+}
+
+/** Find the first node not smaller than the key.
+ *
+ * @param tree The tree to search.
+ * @param key Key to look for.
+ * @param compare Function comparing the key with a node.
+ * @return The first node that is equal or bigger, NULL if there is none.
+ */
+static inline rb_node_t* rb_tree_lower_bound(rb_tree_t* tree, const void* key,
+        rb_compare_key_func_t compare) {
+    rb_node_t* node = tree->root;
+    rb_node_t* result = NULL;
+    while (node != NULL) {
+        if (compare(key, node) <= 0) {
+            result = node;
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+    return result;
+}
+
+/** Make new_child take the place of child below its parent. */
+static inline void rb_replace_child(rb_tree_t* tree, rb_node_t* child,
+        rb_node_t* new_child) {
+    rb_node_t* parent = child->parent;
+    if (parent == NULL) {
+        tree->root = new_child;
+    } else if (parent->left == child) {
+        parent->left = new_child;
+    } else {
+        parent->right = new_child;
+    }
+    if (new_child != NULL) {
+        new_child->parent = parent;
+    }
+}
+
+static inline void rb_rotate_left(rb_tree_t* tree, rb_node_t* node) {
+    rb_node_t* pivot = node->right;
+
+    node->right = pivot->left;
+    if (pivot->left != NULL) {
+        pivot->left->parent = node;
+    }
+    rb_replace_child(tree, node, pivot);
+    pivot->left = node;
+    node->parent = pivot;
+}
+
+static inline void rb_rotate_right(rb_tree_t* tree, rb_node_t* node) {
+    rb_node_t* pivot = node->left;
+
+    node->left = pivot->right;
+    if (pivot->right != NULL) {
+        pivot->right->parent = node;
+    }
+    rb_replace_child(tree, node, pivot);
+    pivot->right = node;
+    node->parent = pivot;
+}
+
+static inline bool rb_node_is_red(rb_node_t* node) {
+    return (node != NULL) && node->red;
+}
+
+/** Insert a node into the tree.
+ *
+ * @param tree The tree to insert to.
+ * @param node The node to insert (must not be in any tree).
+ * @param compare Function ordering the nodes.
+ */
+static inline void rb_tree_insert(rb_tree_t* tree, rb_node_t* node,
+        rb_compare_func_t compare) {
+    assert(tree != NULL);
+    assert(node != NULL);
+
+    rb_node_t* parent = NULL;
+    rb_node_t** link = &tree->root;
+    while (*link != NULL) {
+        parent = *link;
+        link = (compare(node, parent) < 0) ? &parent->left : &parent->right;
+    }
+
+    node->parent = parent;
+    node->left = NULL;
+    node->right = NULL;
+    node->red = true;
+    *link = node;
+
+    // Restore the invariants: only a red node with a red parent can break
+    // them and the root is black so a red parent always has a parent.
+    // Rotations end the loop, recoloring moves the problem up the tree.
+    while (rb_node_is_red(node->parent)) {
+        parent = node->parent;
+        rb_node_t* grandparent = parent->parent;
+
+        if (parent == grandparent->left) {
+            rb_node_t* uncle = grandparent->right;
+            if (rb_node_is_red(uncle)) {
+                parent->red = false;
+                uncle->red = false;
+                grandparent->red = true;
+                node = grandparent;
+                continue;
+            }
+            if (node == parent->right) {
+                rb_rotate_left(tree, parent);
+                parent = node;
+            }
+            parent->red = false;
+            grandparent->red = true;
+            rb_rotate_right(tree, grandparent);
+            break;
+        } else {
+            rb_node_t* uncle = grandparent->left;
+            if (rb_node_is_red(uncle)) {
+                parent->red = false;
+                uncle->red = false;
+                grandparent->red = true;
+                node = grandparent;
+                continue;
+            }
+            if (node == parent->left) {
+                rb_rotate_right(tree, parent);
+                parent = node;
+            }
+            parent->red = false;
+            grandparent->red = true;
+            rb_rotate_left(tree, grandparent);
+            break;
+        }
+    }
+    tree->root->red = false;
+}
+
+/** Remove a node from the tree.
+ *
+ * @param tree The tree the node is in.
+ * @param node The node to remove.
+ */
+static inline void rb_tree_remove(rb_tree_t* tree, rb_node_t* node) {
+    assert(tree != NULL);
+    assert(node != NULL);
+
+    // Child takes the place of the node that is really unlinked (which
+    // has at most one child) and parent is its new parent.
+    rb_node_t* child;
+    rb_node_t* parent;
+    bool removed_red;
+
+    if ((node->left == NULL) || (node->right == NULL)) {
+        child = (node->left != NULL) ? node->left : node->right;
+        parent = node->parent;
+        removed_red = node->red;
+        rb_replace_child(tree, node, child);
+    } else {
+        // Unlink the successor instead and put it to the place of the node.
+        rb_node_t* successor = rb_node_leftmost(node->right);
+        child = successor->right;
+        removed_red = successor->red;
+
+        if (successor->parent == node) {
+            parent = successor;
+        } else {
+            parent = successor->parent;
+            parent->left = child;
+            if (child != NULL) {
+                child->parent = parent;
+            }
+            successor->right = node->right;
+            successor->right->parent = successor;
+        }
+
+        rb_replace_child(tree, node, successor);
+        successor->left = node->left;
+        successor->left->parent = successor;
+        successor->red = node->red;
+    }
+
+    node->parent = NULL;
+    node->left = NULL;
+    node->right = NULL;
+
+    if (removed_red) {
+        return;
+    }
+
+    // Removed black node: the child's side is short of one black node.
+    while ((child != tree->root) && !rb_node_is_red(child)) {
+        if (child == parent->left) {
+            rb_node_t* sibling = parent->right;
+            if (sibling->red) {
+                sibling->red = false;
+                parent->red = true;
+                rb_rotate_left(tree, parent);
+                sibling = parent->right;
+            }
+            if (!rb_node_is_red(sibling->left) && !rb_node_is_red(sibling->right)) {
+                sibling->red = true;
+                child = parent;
+                parent = child->parent;
+                continue;
+            }
+            if (!rb_node_is_red(sibling->right)) {
+                sibling->left->red = false;
+                sibling->red = true;
+                rb_rotate_right(tree, sibling);
+                sibling = parent->right;
+            }
+            sibling->red = parent->red;
+            parent->red = false;
+            sibling->right->red = false;
+            rb_rotate_left(tree, parent);
+        } else {
+            rb_node_t* sibling = parent->left;
+            if (sibling->red) {
+                sibling->red = false;
+                parent->red = true;
+                rb_rotate_right(tree, parent);
+                sibling = parent->left;
+            }
+            if (!rb_node_is_red(sibling->left) && !rb_node_is_red(sibling->right)) {
+                sibling->red = true;
+                child = parent;
+                parent = child->parent;
+                continue;
+            }
+            if (!rb_node_is_red(sibling->left)) {
+                sibling->right->red = false;
+                sibling->red = true;
+                rb_rotate_left(tree, sibling);
+                sibling = parent->left;
+            }
+            sibling->red = parent->red;
+            parent->red = false;
+            sibling->left->red = false;
+            rb_rotate_right(tree, parent);
+        }
+        child = tree->root;
+    }
+    if (child != NULL) {
+        child->red = false;
+    }
+}
+
+#endif
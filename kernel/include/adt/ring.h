@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#ifndef _ADT_RING_H
+#define _ADT_RING_H
+
+#include <debug.h>
+#include <lib/atomic.h>
+#include <types.h>
+
+/*
+ * Bounded lock-free ring buffers of pointers.
+ *
+ * The storage is provided by the caller and its capacity must be a power
+ * of two so that positions can be kept as free-running counters and mapped
+ * to slots with a mask (the counters are allowed to wrap around).
+ *
+ * spsc_ring_t works for exactly one producer and one consumer (e.g. a thread
+ * and an interrupt handler), it needs no atomic instructions at all:
+ *
+ * void* slots[16];
+ * spsc_ring_t ring;
+ * spsc_ring_init(&ring, slots, 16);
+ *
+ * spsc_ring_push(&ring, item);          // producer side
+ * if (spsc_ring_pop(&ring, &item)) {    // consumer side
+ *     ...
+ * }
+ *
+ * mpsc_ring_t allows any number of concurrent producers (which reserve
+ * slots with ll/sc) but still only one consumer. Each slot carries
+ * a sequence number telling whether it was already published.
+ */
+
+/** Check whether the value is a (non-zero) power of two. */
+#define ring_is_power_of_two(value) \
+    (((value) != 0) && (((value) & ((value)-1)) == 0))
+
+/** Single-producer single-consumer ring. */
+typedef struct {
+    /** Position of the next item to pop (written by the consumer only). */
+    volatile unative_t head;
+    /** Position of the next free slot (written by the producer only). */
+    volatile unative_t tail;
+    unative_t mask;
+    void** slots;
+} spsc_ring_t;
+
+/** One slot of the multi-producer ring. */
+typedef struct {
+    volatile unative_t sequence;
+    void* item;
+} mpsc_ring_slot_t;
+
+/** Multi-producer single-consumer ring. */
+typedef struct {
+    volatile unative_t head;
+    volatile unative_t tail;
+    unative_t mask;
+    mpsc_ring_slot_t* slots;
+} mpsc_ring_t;
+
+/** Initialize an empty SPSC ring.
+ *
+ * @param ring Ring to initialize.
+ * @param slots Storage for the items.
+ * @param capacity Number of slots, must be a power of two.
+ */
+static inline void spsc_ring_init(spsc_ring_t* ring, void** slots,
+        size_t capacity) {
+    assert(ring != NULL);
+    assert(ring_is_power_of_two(capacity));
+
+    ring->head = 0;
+    ring->tail = 0;
+    ring->mask = capacity - 1;
+    ring->slots = slots;
+}
+
+/** Get number of items in the ring.
+ *
+ * The value is exact only when called by the producer or the consumer
+ * (the other side can only make it bigger or smaller respectively).
+ *
+ * @param ring Ring in question.
+ */
+static inline size_t spsc_ring_get_size(spsc_ring_t* ring) {
+    return ring->tail - ring->head;
+}
+
+/** Test whether the ring is empty.
+ *
+ * @param ring Ring in question.
+ */
+static inline bool spsc_ring_is_empty(spsc_ring_t* ring) {
+    return ring->tail == ring->head;
+}
+
+/** Append an item (producer only).
+ *
+ * @param ring Ring to append to.
+ * @param item Item to append.
+ * @return Whether the item was appended (false when the ring is full).
+ */
+static inline bool spsc_ring_push(spsc_ring_t* ring, void* item) {
+    unative_t tail = ring->tail;
+    if (tail - ring->head > ring->mask) {
+        return false;
+    }
+
+    ring->slots[tail & ring->mask] = item;
+
+    // Publish the item before the consumer can see the new tail.
+    memory_barrier();
+    ring->tail = tail + 1;
+    return true;
+}
+
+/** Remove the oldest item (consumer only).
+ *
+ * @param ring Ring to remove from.
+ * @param item_out Where to store the removed item.
+ * @return Whether an item was removed (false when the ring is empty).
+ */
+static inline bool spsc_ring_pop(spsc_ring_t* ring, void** item_out) {
+    unative_t head = ring->head;
+    if (head == ring->tail) {
+        return false;
+    }
+
+    // Do not read the slot before we have seen the tail covering it.
+    memory_barrier();
+    *item_out = ring->slots[head & ring->mask];
+
+    // The producer may reuse the slot once the head moves past it.
+    memory_barrier();
+    ring->head = head + 1;
+    return true;
+}
+
+/** Initialize an empty MPSC ring.
+ *
+ * @param ring Ring to initialize.
+ * @param slots Storage for the items.
+ * @param capacity Number of slots, must be a power of two.
+ */
+static inline void mpsc_ring_init(mpsc_ring_t* ring, mpsc_ring_slot_t* slots,
+        size_t capacity) {
+    assert(ring != NULL);
+    assert(ring_is_power_of_two(capacity));
+
+    ring->head = 0;
+    ring->tail = 0;
+    ring->mask = capacity - 1;
+    ring->slots = slots;
+    for (size_t i = 0; i < capacity; i++) {
+        slots[i].sequence = i;
+        slots[i].item = NULL;
+    }
+}
+
+/** Append an item (any producer).
+ *
+ * A slot at position pos is free for the producer when its sequence equals
+ * pos, the producer then claims the position by moving the tail with ll/sc
+ * and publishes the item by setting the sequence to pos + 1.
+ *
+ * @param ring Ring to append to.
+ * @param item Item to append.
+ * @return Whether the item was appended (false when the ring is full).
+ */
+static inline bool mpsc_ring_push(mpsc_ring_t* ring, void* item) {
+    while (true) {
+        unative_t tail = ring->tail;
+        mpsc_ring_slot_t* slot = &ring->slots[tail & ring->mask];
+        native_t diff = (native_t)(slot->sequence - tail);
+
+        if (diff < 0) {
+            // Slot still holds an item from the previous lap.
+            return false;
+        }
+        if ((diff == 0)
+                && atomic_compare_and_swap(&ring->tail, tail, tail + 1)) {
+            slot->item = item;
+            memory_barrier();
+            slot->sequence = tail + 1;
+            return true;
+        }
+        // Another producer claimed the position, try the next one.
+    }
+}
+
+/** Remove the oldest item (single consumer only).
+ *
+ * @param ring Ring to remove from.
+ * @param item_out Where to store the removed item.
+ * @return Whether an item was removed (false when the ring is empty or the
+ *         oldest item was claimed but not yet published).
+ */
+static inline bool mpsc_ring_pop(mpsc_ring_t* ring, void** item_out) {
+    unative_t head = ring->head;
+    mpsc_ring_slot_t* slot = &ring->slots[head & ring->mask];
+    if (slot->sequence != head + 1) {
+        return false;
+    }
+
+    memory_barrier();
+    *item_out = slot->item;
+
+    // Make the slot free for the producers of the next lap.
+    memory_barrier();
+    slot->sequence = head + ring->mask + 1;
+    ring->head = head + 1;
+    return true;
+}
+
+#endif
@@ -24,11 +24,15 @@
 
 /*
  * When assertion in kernel fails, we halt the machine.
+ *
+ * Assertions and panics print synchronously so that nothing buffered
+ * is lost when the machine halts.
  */
 #ifdef KERNEL_DEBUG
 #define assert(expr) \
     do { \
         if (!(expr)) { \
+            printk_set_sync(true); \
             puts("Assert failed at " __FILE__ ":" QUOTE_ME(__LINE__) ": " #expr); \
             machine_halt(); \
         } \
@@ -44,6 +48,7 @@
 #define panic_if(expr, fmt, ...) \
     do { \
         if ((expr)) { \
+            printk_set_sync(true); \
             printk("Kernel panic: " fmt "\n", ##__VA_ARGS__); \
             puts("Location: " __FILE__ ":" QUOTE_ME(__LINE__)); \
             puts("Condition: " #expr); \
@@ -53,6 +58,7 @@
 
 #define panic(fmt, ...) \
     do { \
+        printk_set_sync(true); \
         printk("Kernel panic: " fmt "\n", ##__VA_ARGS__); \
         puts("Location: " __FILE__ ":" QUOTE_ME(__LINE__)); \
         machine_halt(); \
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#ifndef _DEBUG_TRACE_H
+#define _DEBUG_TRACE_H
+
+#include <drivers/cp0.h>
+#include <lib/print.h>
+#include <proc/thread.h>
+#include <types.h>
+
+/*
+ * Scheduler tracing (only when compiled with KERNEL_TRACE).
+ *
+ * Events are stored with CP0 Count timestamps into a fixed-size ring in
+ * memory (the oldest ones are overwritten), recording costs just a few
+ * stores. trace_dump() prints the ring after the interesting part of the
+ * run, tools/trace.py turns the output into per-thread statistics.
+ */
+
+/** Number of records kept (must be a power of two). */
+#define TRACE_BUFFER_SIZE 1024
+
+/** Number of thread names remembered for the dump. */
+#define TRACE_NAMES 64
+
+typedef enum {
+    /** Thread was created (arg is the creating thread id). */
+    TRACE_CREATE,
+    /** Thread got the processor (arg is id of the previous thread). */
+    TRACE_SWITCH_IN,
+    /** Thread gave up the processor (arg is its new state). */
+    TRACE_SWITCH_OUT,
+    /** Thread was suspended (arg is id of the suspending thread). */
+    TRACE_SUSPEND,
+    /** Suspended thread was woken-up (arg is id of the waking thread). */
+    TRACE_WAKEUP,
+    /** Thread finished. */
+    TRACE_FINISH,
+} trace_event_t;
+
+typedef struct {
+    unative_t timestamp;
+    unative_t event;
+    unative_t thread_id;
+    unative_t arg;
+} trace_record_t;
+
+#ifdef KERNEL_TRACE
+
+extern trace_record_t trace_buffer[TRACE_BUFFER_SIZE];
+extern unative_t trace_position;
+
+/** Store one event into the trace ring.
+ *
+ * @param event Event type.
+ * @param thread Thread the event relates to.
+ * @param arg Event-specific argument.
+ */
+static inline void trace_record(trace_event_t event, thread_t* thread, unative_t arg) {
+    trace_record_t* record = &trace_buffer[trace_position & (TRACE_BUFFER_SIZE - 1)];
+    record->timestamp = cp0_read_count();
+    record->event = event;
+    record->thread_id = thread->id;
+    record->arg = arg;
+    trace_position++;
+}
+
+void trace_thread_created(thread_t* thread);
+void trace_reset(void);
+size_t trace_get_count(void);
+trace_record_t* trace_get(size_t index);
+void trace_dump_to(print_sink_t* out);
+void trace_dump(void);
+
+#else
+
+#define trace_record(event, thread, arg) ((void)0)
+#define trace_thread_created(thread) ((void)0)
+#define trace_reset() ((void)0)
+#define trace_dump_to(out) ((void)0)
+#define trace_dump() ((void)0)
+
+#endif
+
+#endif
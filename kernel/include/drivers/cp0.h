@@ -0,0 +1,22 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#ifndef _DRIVERS_CP0_H
+#define _DRIVERS_CP0_H
+
+#include <types.h>
+
+/** Read the CP0 Count register.
+ *
+ * The register is incremented by the (virtual) CPU every cycle and wraps
+ * around silently, so compute differences using unsigned arithmetic.
+ *
+ * @return Current value of the cycle counter.
+ */
+static inline unative_t cp0_read_count(void) {
+    unative_t count;
+    __asm__ volatile("mfc0 %0, $9\n" : "=r"(count));
+    return count;
+}
+
+#endif
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#ifndef _KBENCH_H
+#define _KBENCH_H
+
+#include <drivers/cp0.h>
+#include <ktest.h>
+
+/*
+ * Micro-benchmarks on top of kernel tests.
+ *
+ * kbench_run() executes the body a few times to warm up caches (and the
+ * thread cache, heap free lists etc.), then measures each of the following
+ * runs with the CP0 Count register and prints one result line:
+ *
+ * kbench_run("heap/kmalloc_free", 4, 32, {
+ *     kfree(kmalloc(64));
+ * });
+ *
+ * [ KBENCH ]: heap/kmalloc_free runs=32 min=130 median=134 max=260
+ *
+ * All numbers are in cycles and include the few cycles needed to read the
+ * counter. tools/tester.py collects these lines from tests listed with
+ * the bench type in a suite file.
+ */
+
+/** Prefix of the result lines, parsed by tools/tester.py. */
+#define KBENCH_RESULT "[ KBENCH ]: "
+
+/** Maximum number of measured runs of one benchmark. */
+#define KBENCH_MAX_RUNS 64
+
+typedef struct {
+    const char* name;
+    size_t runs;
+    size_t recorded;
+    unative_t samples[KBENCH_MAX_RUNS];
+} kbench_t;
+
+/** Run and measure a benchmark body.
+ *
+ * @param bench_name Benchmark name (reported as is, without spaces).
+ * @param warmup_runs Number of unmeasured runs executed first.
+ * @param measured_runs Number of measured runs (at most KBENCH_MAX_RUNS).
+ * @param ... Body of the benchmark (statement or block).
+ */
+#define kbench_run(bench_name, warmup_runs, measured_runs, ...) \
+    do { \
+        kbench_t _kbench; \
+        kbench_init(&_kbench, bench_name, measured_runs); \
+        for (size_t _kbench_i = 0; _kbench_i < (warmup_runs); _kbench_i++) { \
+            __VA_ARGS__; \
+        } \
+        while (_kbench.recorded < _kbench.runs) { \
+            unative_t _kbench_start = cp0_read_count(); \
+            __VA_ARGS__; \
+            kbench_record(&_kbench, cp0_read_count() - _kbench_start); \
+        } \
+        kbench_report(&_kbench); \
+    } while (0)
+
+static inline void kbench_init(kbench_t* bench, const char* name, size_t runs) {
+    ktest_assert((runs > 0) && (runs <= KBENCH_MAX_RUNS),
+            "benchmark %s: %u runs out of range", name, runs);
+
+    bench->name = name;
+    bench->runs = runs;
+    bench->recorded = 0;
+}
+
+/** Insert the sample so that the recorded ones stay sorted. */
+static inline void kbench_record(kbench_t* bench, unative_t cycles) {
+    size_t i = bench->recorded;
+    while ((i > 0) && (bench->samples[i - 1] > cycles)) {
+        bench->samples[i] = bench->samples[i - 1];
+        i--;
+    }
+    bench->samples[i] = cycles;
+    bench->recorded++;
+}
+
+static inline void kbench_report(kbench_t* bench) {
+    printk(KBENCH_RESULT "%s runs=%u min=%u median=%u max=%u\n",
+            bench->name, bench->runs, bench->samples[0],
+            bench->samples[bench->runs / 2], bench->samples[bench->runs - 1]);
+}
+
+#endif
@@ -26,6 +26,7 @@
 /** Print message about passed failed test and halts the CPU. */
 #define ktest_failed() \
     do { \
+        printk_set_sync(true); \
         puts("\n\nTest failed.\n\n"); \
         machine_halt(); \
     } while (0)
@@ -38,6 +39,7 @@
 #define ktest_assert(expr, fmt, ...) \
     do { \
         if (!(expr)) { \
+            printk_set_sync(true); \
             puts("\n\n" __FILE__ ":" QUOTE_ME(__LINE__) ": Kernel test assertion failed: " #expr); \
             printk(__FILE__ ":" QUOTE_ME(__LINE__) ": " fmt "\n", ##__VA_ARGS__); \
             ktest_failed(); \
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#ifndef _LIB_ATOMIC_H
+#define _LIB_ATOMIC_H
+
+#include <types.h>
+
+/*
+ * Memory barriers and atomic read-modify-write operations for MIPS.
+ *
+ * Atomic operations use the ll/sc (load linked/store conditional) pair
+ * available since MIPS II: sc succeeds only when nobody wrote the word
+ * since the matching ll, otherwise the whole sequence is retried.
+ */
+
+/** Prevent the compiler from reordering memory accesses around this point. */
+static inline void compiler_barrier(void) {
+    __asm__ volatile("" ::: "memory");
+}
+
+/** Full memory barrier: all loads and stores before it complete first. */
+static inline void memory_barrier(void) {
+    __asm__ volatile("sync\n" ::: "memory");
+}
+
+/** Atomically replace the value when it still has the expected value.
+ *
+ * @param ptr Word to update.
+ * @param expected Value the word must contain.
+ * @param new_value Value to store.
+ * @return Whether the value was replaced.
+ */
+static inline bool atomic_compare_and_swap(volatile unative_t* ptr,
+        unative_t expected, unative_t new_value) {
+    unative_t loaded;
+    unative_t result;
+    // clang-format off
+    __asm__ volatile(
+        ".set push\n"
+        ".set noreorder\n"
+        "1:\n"
+        "    ll %[loaded], %[mem]\n"
+        "    bne %[loaded], %[expected], 2f\n"
+        "    move %[result], $0\n"
+        "    move %[result], %[new_value]\n"
+        "    sc %[result], %[mem]\n"
+        "    beqz %[result], 1b\n"
+        "    nop\n"
+        "2:\n"
+        ".set pop\n"
+        : [loaded] "=&r"(loaded), [result] "=&r"(result), [mem] "+m"(*ptr)
+        : [expected] "r"(expected), [new_value] "r"(new_value)
+        : "memory");
+    // clang-format on
+    return result != 0;
+}
+
+/** Atomically add to a word.
+ *
+ * @param ptr Word to update.
+ * @param addend Value to add.
+ * @return Value of the word before the addition.
+ */
+static inline unative_t atomic_fetch_add(volatile unative_t* ptr,
+        unative_t addend) {
+    unative_t old_value;
+    unative_t new_value;
+    // clang-format off
+    __asm__ volatile(
+        ".set push\n"
+        ".set noreorder\n"
+        "1:\n"
+        "    ll %[old], %[mem]\n"
+        "    addu %[new], %[old], %[addend]\n"
+        "    sc %[new], %[mem]\n"
+        "    beqz %[new], 1b\n"
+        "    nop\n"
+        ".set pop\n"
+        : [old] "=&r"(old_value), [new] "=&r"(new_value), [mem] "+m"(*ptr)
+        : [addend] "r"(addend)
+        : "memory");
+    // clang-format on
+    return old_value;
+}
+
+#endif
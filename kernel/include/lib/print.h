@@ -4,6 +4,8 @@
 #ifndef _LIB_PRINT_H
 #define _LIB_PRINT_H
 
+#include <errno.h>
+#include <lib/stdarg.h>
 #include <types.h>
 
 /** Type for representing base of a number.*/
@@ -20,11 +22,138 @@ void fputs(const char* s);
 void puts(const char* s);
 
 /** Prints given formatted string to console.
- * Supported printf formats: %c, %d, %u, %s, %x, %X, %p, %pL
+ * Supported printf formats: %c, %d, %i, %u, %o, %s, %x, %X, %p, %pL, %pT
+ * with flags '-', '0', '+' and ' ', width and precision (number or '*')
+ * and length modifiers l, z (no-op) and ll (64-bit integers).
  * @param format printf-style formatting string.
  */
 void printk(const char* format, ...);
 
+/** Destination of formatted output.
+ *
+ * printk prints to the console sink, snprintk to a memory buffer sink.
+ * Other sinks embed print_sink_t as their first member.
+ */
+typedef struct print_sink {
+    /** Output one character. */
+    void (*putchar)(struct print_sink* sink, char c);
+    /** Number of characters output so far. */
+    size_t length;
+} print_sink_t;
+
+/** Sink writing to a fixed-size memory buffer.
+ *
+ * Output that does not fit is dropped (but still counted).
+ */
+typedef struct {
+    print_sink_t base;
+    char* buffer;
+    size_t size;
+} print_buffer_sink_t;
+
+/** Get the sink printk prints to (i.e. the console). */
+print_sink_t* printk_get_sink(void);
+
+/** Like printk but with arguments as va_list.
+ * @param format printf-style formatting string.
+ * @param args Arguments for the format.
+ */
+void vprintk(const char* format, va_list args);
+
+/** Print formatted output to given sink (formats as printk).
+ * @param sink Where to print.
+ * @param format printf-style formatting string.
+ * @return Number of characters printed.
+ */
+size_t fprintk(print_sink_t* sink, const char* format, ...);
+
+/** Like fprintk but with arguments as va_list.
+ * @param sink Where to print.
+ * @param format printf-style formatting string.
+ * @param args Arguments for the format.
+ * @return Number of characters printed.
+ */
+size_t vfprintk(print_sink_t* sink, const char* format, va_list args);
+
+/** Format into a memory buffer (formats as printk).
+ * The result is always zero-terminated (unless size is zero).
+ * @param buffer Where to store the result.
+ * @param size Size of the buffer.
+ * @param format printf-style formatting string.
+ * @return Length of the whole output (even the part that did not fit).
+ */
+size_t snprintk(char* buffer, size_t size, const char* format, ...);
+
+/** Like snprintk but with arguments as va_list.
+ * @param buffer Where to store the result.
+ * @param size Size of the buffer.
+ * @param format printf-style formatting string.
+ * @param args Arguments for the format.
+ * @return Length of the whole output (even the part that did not fit).
+ */
+size_t vsnprintk(char* buffer, size_t size, const char* format, va_list args);
+
+/** Initialize sink writing to a memory buffer.
+ * @param sink Sink to initialize.
+ * @param buffer Where to store the output.
+ * @param size Size of the buffer.
+ */
+void print_buffer_sink_init(print_buffer_sink_t* sink, char* buffer, size_t size);
+
+/** Zero-terminate output printed to a memory buffer sink so far.
+ * @param sink Sink to terminate.
+ */
+void print_buffer_sink_terminate(print_buffer_sink_t* sink);
+
+/*
+ * Console output is buffered only in kernels configured with
+ * --buffered-printk (KERNEL_PRINTK_BUFFERED), otherwise every character
+ * goes directly to the console device and the functions below do nothing.
+ */
+
+/** Write all buffered console output to the console device.
+ *
+ * Normally the output is written by the flusher thread, calling this
+ * explicitly is needed only before halting the machine.
+ */
+void printk_flush(void);
+
+/** Write buffered console output after a CPU exception.
+ *
+ * Called from the exception vector after MSIM dumped the registers. It is
+ * a leaf function without stack frame, the stack pointer may be broken.
+ */
+void printk_flush_on_exception(void);
+
+/** Switch between synchronous and buffered console output.
+ *
+ * In synchronous mode every character goes directly to the console device
+ * (switching to it flushes the buffer first). Output is synchronous until
+ * printk_start_flusher() is called and panics switch back to it.
+ *
+ * @param sync Whether to write synchronously.
+ */
+void printk_set_sync(bool sync);
+
+/** Start the thread draining the console buffer and enable buffering.
+ *
+ * When the flusher cannot be started the output stays synchronous.
+ *
+ * @return Error code.
+ * @retval EOK Flusher was started.
+ * @retval ENOMEM Not enough memory for the flusher thread.
+ * @retval ENOIMPL Kernel was built without buffered console output.
+ */
+errno_t printk_start_flusher(void);
+
+/** Wake-up the flusher thread when there is buffered output.
+ *
+ * The flusher has low priority: it is woken only when no other thread is
+ * ready or when the buffer is at least half full. Called by the scheduler
+ * before it picks the next thread.
+ */
+void printk_poll_flusher(void);
+
 /**
  * TODO
  */
@@ -64,6 +193,4 @@ int int32_to_str(int32_t n, base_t base, char* buf, size_t buflen);
  */
 int uint32_to_str(uint32_t n, base_t base, char* buf, size_t buflen);
 
-char* strncpy(char* dest, const char* src, size_t n);
-
 #endif
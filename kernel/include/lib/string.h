@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#ifndef _LIB_STRING_H
+#define _LIB_STRING_H
+
+#include <types.h>
+
+/*
+ * Memory and string primitives (with the usual C semantics).
+ *
+ * Bulk of the work is done a word at a time, bytes are used only to reach
+ * alignment of the destination and for the tail. When source and destination
+ * are aligned differently, source words are loaded with unaligned loads
+ * (lwl/lwr pairs on MIPS).
+ */
+
+/** Copy memory, the areas must not overlap.
+ * @param dest Destination.
+ * @param src Source.
+ * @param n Number of bytes to copy.
+ * @return dest
+ */
+void* memcpy(void* dest, const void* src, size_t n);
+
+/** Copy memory, the areas may overlap.
+ * @param dest Destination.
+ * @param src Source.
+ * @param n Number of bytes to copy.
+ * @return dest
+ */
+void* memmove(void* dest, const void* src, size_t n);
+
+/** Fill memory with a byte.
+ * @param dest Memory to fill.
+ * @param c Byte value (converted to unsigned char).
+ * @param n Number of bytes to fill.
+ * @return dest
+ */
+void* memset(void* dest, int c, size_t n);
+
+/** Compare memory areas.
+ * @param a First area.
+ * @param b Second area.
+ * @param n Number of bytes to compare.
+ * @return Negative, zero or positive number when the first differing byte
+ *         (as unsigned char) is smaller in a, there is none, or it is bigger.
+ */
+int memcmp(const void* a, const void* b, size_t n);
+
+/** Get length of a zero-terminated string.
+ * @param s String in question.
+ * @return Number of characters before the terminating zero.
+ */
+size_t strlen(const char* s);
+
+/** Copy at most n characters of a string, padding the rest with zeroes.
+ * @param dest Destination.
+ * @param src Zero-terminated source.
+ * @param n Size of destination.
+ * @return dest
+ */
+char* strncpy(char* dest, const char* src, size_t n);
+
+#endif
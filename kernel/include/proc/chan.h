@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#ifndef _PROC_CHAN_H
+#define _PROC_CHAN_H
+
+#include <errno.h>
+#include <proc/sync.h>
+#include <types.h>
+
+/** Bounded channel passing pointer-sized messages between threads.
+ *
+ * Messages are delivered in FIFO order. A message sent while a receiver is
+ * parked is handed directly to that receiver, bypassing the buffer.
+ * Channels with zero capacity are rendezvous points.
+ */
+typedef struct chan {
+    size_t capacity;
+    size_t count;
+    /** Index of the oldest buffered message. */
+    size_t head;
+    /** Buffer of capacity messages (allocated right after the structure). */
+    void** buffer;
+    waitq_t receivers;
+    waitq_t senders;
+} chan_t;
+
+errno_t chan_create(chan_t** chan_out, size_t capacity);
+void chan_destroy(chan_t* chan);
+void chan_send(chan_t* chan, void* message);
+errno_t chan_try_send(chan_t* chan, void* message);
+void* chan_recv(chan_t* chan);
+errno_t chan_try_recv(chan_t* chan, void** message_out);
+
+#endif
@@ -73,6 +73,7 @@ typedef struct {
 } context_t;
 
 void cpu_switch_context(void** stack_top_old, void** stack_top_new, asid_t asid_new);
+void cpu_switch_context_fast(void** stack_top_old, void** stack_top_new, asid_t asid_new);
 
 #endif
 
@@ -153,6 +154,41 @@ void cpu_switch_context(void** stack_top_old, void** stack_top_new, asid_t asid_
 
     lw $zero, 0(\base)
 .endm LOAD_REGISTERS
+
+/*
+ * Registers preserved across a function call by the o32 ABI, stored at the
+ * same offsets as by SAVE_REGISTERS so that both kinds of frames share the
+ * context_t layout.
+ */
+.macro SAVE_CALLEE_SAVED_REGISTERS base
+    sw $s0, 72(\base)
+    sw $s1, 76(\base)
+    sw $s2, 80(\base)
+    sw $s3, 84(\base)
+    sw $s4, 88(\base)
+    sw $s5, 92(\base)
+    sw $s6, 96(\base)
+    sw $s7, 100(\base)
+
+    sw $gp, 112(\base)
+    sw $fp, 116(\base)
+    sw $ra, 124(\base)
+.endm SAVE_CALLEE_SAVED_REGISTERS
+
+.macro LOAD_CALLEE_SAVED_REGISTERS base
+    lw $ra, 124(\base)
+    lw $fp, 116(\base)
+    lw $gp, 112(\base)
+
+    lw $s7, 100(\base)
+    lw $s6, 96(\base)
+    lw $s5, 92(\base)
+    lw $s4, 88(\base)
+    lw $s3, 84(\base)
+    lw $s2, 80(\base)
+    lw $s1, 76(\base)
+    lw $s0, 72(\base)
+.endm LOAD_CALLEE_SAVED_REGISTERS
 // clang-format on
 #endif
 
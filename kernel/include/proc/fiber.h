@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#ifndef _PROC_FIBER_H
+#define _PROC_FIBER_H
+
+#include <adt/list.h>
+#include <errno.h>
+#include <types.h>
+
+/** Default fiber stack size. */
+#define FIBER_STACK_SIZE 1024
+
+/** Minimal fiber stack size (saved context takes CONTEXT_SIZE of it). */
+#define FIBER_STACK_SIZE_MIN 512
+
+/** Fiber entry function. */
+typedef void (*fiber_func_t)(void*);
+
+/** Cooperative coroutine with its own (small) stack.
+ *
+ * Fibers run inside one kernel thread and switch among themselves without
+ * the scheduler being involved. The stack is placed right after this
+ * structure, both are freed when the fiber finishes (the pointer must not
+ * be used after that).
+ *
+ * There is no stackless or shared-stack mode, every fiber costs at least
+ * FIBER_STACK_SIZE_MIN plus this structure and the heap block header
+ * (about 560 B). That gives roughly 1800 concurrent fibers per MiB of
+ * heap, i.e. thousands, not tens of thousands, in the default machine.
+ */
+typedef struct fiber {
+    unative_t stack_top;
+    fiber_func_t entry_func;
+    void* data;
+    size_t stack_size;
+    struct fiber_sched* sched;
+    /** Link in the queue of ready fibers. */
+    link_t link;
+} fiber_t;
+
+/** Set of fibers executed together by one kernel thread. */
+typedef struct fiber_sched {
+    /** Ready fibers except the running one. */
+    list_t ready;
+    /** Running fiber (NULL when the kernel thread itself runs). */
+    fiber_t* current;
+    /** Context of the kernel thread while it executes fibers. */
+    unative_t root_stack_top;
+    /** Finished fiber whose memory could not be freed on its own stack. */
+    fiber_t* zombie;
+    size_t fiber_count;
+} fiber_sched_t;
+
+void fiber_sched_init(fiber_sched_t* sched);
+errno_t fiber_create(fiber_t** fiber_out, fiber_sched_t* sched, fiber_func_t entry, void* data, size_t stack_size);
+void fiber_run(fiber_sched_t* sched);
+fiber_t* fiber_get_current(void);
+void fiber_yield(void);
+errno_t fiber_switch(fiber_t* fiber);
+
+#endif
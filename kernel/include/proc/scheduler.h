@@ -7,9 +7,19 @@
 #include <errno.h>
 #include <proc/thread.h>
 
+/** Maximum credit (in cycles) a woken thread gets under fair scheduling.
+ *
+ * A thread woken after a long sleep is placed at most this far before the
+ * least-served runnable thread, so it runs soon but cannot monopolize the
+ * processor to catch up on the time it slept.
+ */
+#ifndef SCHEDULER_FAIR_WAKEUP_BONUS
+#define SCHEDULER_FAIR_WAKEUP_BONUS 20000
+#endif
+
 void scheduler_init(void);
 
-void scheduler_add_ready_thread(thread_t* id);
+errno_t scheduler_add_ready_thread(thread_t* id);
 
 void scheduler_remove_thread(thread_t* id);
 
@@ -25,6 +35,10 @@ errno_t scheduler_wakeup_thread(thread_t* id);
 
 void scheduler_schedule_next(void);
 
+errno_t scheduler_yield_to(thread_t* thread);
+
 thread_t* scheduler_get_running_thread(void);
 
+size_t scheduler_get_ready_count(void);
+
 #endif
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#ifndef _PROC_SYNC_H
+#define _PROC_SYNC_H
+
+#include <adt/list.h>
+#include <errno.h>
+#include <proc/thread.h>
+#include <types.h>
+
+/** One thread parked in a wait queue.
+ *
+ * The structure lives on the stack of the waiting thread (which is not
+ * running while it is parked) so waiting never allocates memory.
+ */
+typedef struct waiter {
+    thread_t* thread;
+    /** Optional payload handed over by the thread that wakes us up. */
+    void* data;
+    volatile bool woken;
+    link_t link;
+} waiter_t;
+
+/** FIFO queue of parked threads. */
+typedef struct {
+    list_t waiters;
+} waitq_t;
+
+/** Maximum number of polls of a running owner before mutex_lock() sleeps.
+ *
+ * Spinning only pays off while the owner executes on another CPU, tune with
+ * lock-hold histograms (see KERNEL_LOCK_STATS).
+ */
+#ifndef MUTEX_SPIN_LIMIT
+#define MUTEX_SPIN_LIMIT 64
+#endif
+
+/** Number of power-of-two buckets of the lock-hold histogram. */
+#define LOCK_STATS_BUCKETS 32
+
+/** Lock usage statistics (collected only with KERNEL_LOCK_STATS). */
+typedef struct {
+    unative_t acquired_at;
+    size_t acquisitions;
+    size_t contended;
+    size_t acquired_by_spinning;
+    /** Bucket i counts hold times in [2^i, 2^(i+1)) cycles. */
+    size_t hold_histogram[LOCK_STATS_BUCKETS];
+} lock_stats_t;
+
+/** Adaptive mutual exclusion lock.
+ *
+ * Waiters spin while the owner is running (on another CPU) and sleep
+ * otherwise. On unlock, ownership is handed directly to the next sleeper.
+ */
+typedef struct {
+    thread_t* owner;
+    waitq_t waitq;
+#ifdef KERNEL_LOCK_STATS
+    lock_stats_t stats;
+#endif
+} mutex_t;
+
+/** Counting semaphore. */
+typedef struct {
+    size_t value;
+    waitq_t waitq;
+} sem_t;
+
+void waitq_init(waitq_t* waitq);
+bool waitq_is_empty(waitq_t* waitq);
+void waitq_sleep(waitq_t* waitq, waiter_t* waiter);
+waiter_t* waitq_pop(waitq_t* waitq);
+void waitq_wake(waiter_t* waiter);
+bool waitq_wakeup_one(waitq_t* waitq);
+void waitq_wakeup_all(waitq_t* waitq);
+
+errno_t mutex_init(mutex_t* mutex);
+void mutex_destroy(mutex_t* mutex);
+void mutex_lock(mutex_t* mutex);
+bool mutex_trylock(mutex_t* mutex);
+void mutex_unlock(mutex_t* mutex);
+void mutex_print_stats(mutex_t* mutex, const char* name);
+
+errno_t sem_init(sem_t* sem, size_t value);
+void sem_destroy(sem_t* sem);
+size_t sem_get_value(sem_t* sem);
+void sem_wait(sem_t* sem);
+errno_t sem_trywait(sem_t* sem);
+void sem_post(sem_t* sem);
+
+#endif
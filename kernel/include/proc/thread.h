@@ -4,22 +4,54 @@
 #ifndef _PROC_THREAD_H
 #define _PROC_THREAD_H
 
+#include <adt/list.h>
 #include <errno.h>
 #include <types.h>
 #include <proc/context.h>
 
-/** Thread stack size.
+/** Default thread stack size.
  *
  * Set quite liberally as stack overflows are notoriously difficult to debug
  * (and difficult to detect too).
  */
 #define THREAD_STACK_SIZE 4096
 
+/** Stack sizes selectable by thread_create flags. */
+#define THREAD_STACK_SIZE_TINY 1024
+#define THREAD_STACK_SIZE_SMALL 2048
+#define THREAD_STACK_SIZE_LARGE 16384
+
+/*
+ * Flags for thread_create: the lowest two bits select the stack size
+ * (no flag means THREAD_STACK_SIZE).
+ */
+#define THREAD_FLAG_STACK_DEFAULT 0x0
+#define THREAD_FLAG_STACK_TINY 0x1
+#define THREAD_FLAG_STACK_SMALL 0x2
+#define THREAD_FLAG_STACK_LARGE 0x3
+#define THREAD_FLAG_STACK_MASK 0x3
+
+/** Max number of finished threads (per stack size) kept for reuse. */
+#define THREAD_CACHE_SIZE 8
+
+/** Size of thread-local storage block of each thread (see proc/tls.h). */
+#define THREAD_TLS_SIZE 128
+
 /** Max length (excluding terminating zero) of thread name. */
 #define THREAD_NAME_MAX_LENGTH 31
 
+/** Word at the very bottom of each stack, overwritten only by an overflow. */
+#define THREAD_STACK_CANARY 0xCA4A21E5
+
+/** Pattern filling unused stack, used to find how deep the stack grew. */
+#define THREAD_STACK_PAINT 0x57ACC0DE
+
+/** Lowest word of the stack (the stack is placed right after thread_t). */
+#define THREAD_STACK_BOTTOM(THREADPTR) \
+    ((unative_t*)((uintptr_t)THREADPTR + sizeof(thread_t)))
+
 #define THREAD_INITIAL_STACK_TOP(THREADPTR) \
-    ((unative_t)((uintptr_t)THREADPTR + sizeof(thread_t) + THREAD_STACK_SIZE))
+    ((unative_t)((uintptr_t)THREADPTR + sizeof(thread_t) + (THREADPTR)->stack_size))
 
 #define THREAD_INITIAL_CONTEXT(THREADPTR) \
     ((context_t*)(THREAD_INITIAL_STACK_TOP(THREADPTR) - sizeof(context_t)))
@@ -34,26 +66,71 @@ typedef enum thread_state {
     FINISHED,
 } thread_state_t;
 
+/** CPU accounting of a thread (all times are in CP0 Count cycles). */
+typedef struct {
+    /** Time spent running. */
+    unative_t run_cycles;
+    /** Time spent ready but waiting for the processor. */
+    unative_t wait_cycles;
+    /** Number of times the thread got the processor. */
+    size_t switches;
+    /** Switches out because the thread suspended itself or finished. */
+    size_t voluntary_switches;
+    /** Switches out while the thread remained ready (e.g. yields). */
+    size_t involuntary_switches;
+} thread_stats_t;
+
+struct fiber_sched;
+
 /** Information about any existing thread. */
 typedef struct thread thread_t;
 struct thread {
+    /** Unique id (never reused, unlike the thread_t memory). */
+    unative_t id;
     char name[THREAD_NAME_MAX_LENGTH + 1];
     thread_entry_func_t entry_func;
     void * data;
     void* retval;
     thread_state_t state;
     unative_t stack_top;
+    /** Size of the stack placed right after this structure. */
+    size_t stack_size;
+
+    /** Processor time used, for ordering under KERNEL_SCHED_FAIR. */
+    unative_t vruntime;
+    /** Position in the ready heap under KERNEL_SCHED_FAIR. */
+    size_t sched_index;
+
+    thread_stats_t stats;
+    /** When the thread got the processor or became ready. */
+    unative_t stats_since;
+
+    /** Thread waiting in thread_join for this one (if any). */
+    thread_t* joiner;
+
+    /** Fibers currently executed by this thread (NULL outside fiber_run). */
+    struct fiber_sched* fiber_sched;
+
+    /** Link in the scheduler ready queue or in the cache of free threads. */
+    link_t link;
+
+    /** Thread-local storage, $gp points here while the thread runs. */
+    unative_t tls[THREAD_TLS_SIZE / sizeof(unative_t)];
 };
 
 void threads_init(void);
 errno_t thread_create(thread_t** thread, thread_entry_func_t entry, void* data, unsigned int flags, const char* name);
 thread_t* thread_get_current(void);
 void thread_yield(void);
+errno_t thread_yield_to(thread_t* thread);
 void thread_suspend(void);
 void thread_finish(void* retval) __attribute__((noreturn));
 bool thread_has_finished(thread_t* thread);
+bool thread_is_running(thread_t* thread);
 errno_t thread_wakeup(thread_t* thread);
 errno_t thread_join(thread_t* thread, void** retval);
+size_t thread_get_stack_usage(thread_t* thread);
+errno_t thread_get_stats(thread_t* thread, thread_stats_t* stats);
 void thread_switch_to(thread_t* thread);
 
 #endif
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#ifndef _PROC_TLS_H
+#define _PROC_TLS_H
+
+#include <errno.h>
+#include <types.h>
+
+/*
+ * Thread-local storage.
+ *
+ * Each thread has a block of THREAD_TLS_SIZE bytes (inside its thread_t)
+ * that is zeroed when the thread is created. Subsystems reserve their part
+ * of the block once (at initialization) with tls_reserve and then reach
+ * the current thread's copy in O(1) through $gp:
+ *
+ * static size_t stats_offset;
+ * tls_reserve(sizeof(my_stats_t), &stats_offset);
+ * ...
+ * my_stats_t* stats = tls_get(stats_offset);
+ *
+ * $gp is free for this purpose because the kernel is compiled with -G 0
+ * and -mno-abicalls (the compiler never uses it but also never allocates
+ * it as an ordinary register). It is saved and restored with the thread
+ * context, the initial context of a thread points it to the thread's TLS
+ * block. Fibers use the TLS of the kernel thread that runs them.
+ *
+ * TLS is available only in threads, not in the boot code that runs before
+ * the first thread.
+ */
+
+/** Get the TLS block of the current thread. */
+static inline void* tls_get_block(void) {
+    void* block;
+    __asm__ volatile("move %0, $gp\n" : "=r"(block));
+    return block;
+}
+
+/** Make the given block the TLS block of the running code.
+ *
+ * Only for the thread and fiber start-up code.
+ */
+static inline void tls_set_block(void* block) {
+    __asm__ volatile("move $gp, %0\n" ::"r"(block));
+}
+
+/** Get the current thread's copy of a reserved TLS area.
+ *
+ * @param offset Offset returned by tls_reserve.
+ */
+static inline void* tls_get(size_t offset) {
+    return (uint8_t*)tls_get_block() + offset;
+}
+
+errno_t tls_reserve(size_t size, size_t* offset_out);
+
+#endif
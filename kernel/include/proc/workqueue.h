@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#ifndef _PROC_WORKQUEUE_H
+#define _PROC_WORKQUEUE_H
+
+#include <errno.h>
+#include <proc/sync.h>
+#include <proc/thread.h>
+#include <types.h>
+
+/** Function executed by a worker thread. */
+typedef void (*work_func_t)(void*);
+
+/** One submitted piece of work. */
+typedef struct {
+    work_func_t func;
+    void* arg;
+} work_t;
+
+/** Pool of worker threads executing submitted work in FIFO order.
+ *
+ * Workers are created once, so submitting work costs neither stack
+ * allocation nor context set-up of a new thread.
+ */
+typedef struct workqueue {
+    size_t worker_count;
+    /** Worker threads (allocated right after the structure). */
+    thread_t** workers;
+
+    size_t capacity;
+    size_t count;
+    /** Index of the oldest queued work. */
+    size_t head;
+    /** Queue of capacity items (allocated after the workers). */
+    work_t* queue;
+
+    /** Work that was submitted but has not finished yet. */
+    size_t pending;
+    bool terminating;
+
+    waitq_t idle_workers;
+    waitq_t submitters;
+    waitq_t completion_waiters;
+} workqueue_t;
+
+errno_t workqueue_create(workqueue_t** wq_out, size_t worker_count, size_t capacity, unsigned int thread_flags);
+void workqueue_destroy(workqueue_t* wq);
+void work_submit(workqueue_t* wq, work_func_t func, void* arg);
+errno_t work_try_submit(workqueue_t* wq, work_func_t func, void* arg);
+void work_wait(workqueue_t* wq);
+
+#endif
@@ -17,7 +17,7 @@ void debug_dump_function(const char* name, uintptr_t address,
         size_t instruction_count) {
     printk("%x <%s>:\n", address, name);
     for (size_t i = 0; i < instruction_count; ++i) {
-        printk("%x:        %8x\n", address, *(uintptr_t*)address);
+        printk("%x:        %08x\n", address, *(uintptr_t*)address);
         address += sizeof(uintptr_t);
     }
 }
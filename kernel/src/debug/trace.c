@@ -0,0 +1,98 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#include <debug.h>
+#include <debug/trace.h>
+#include <lib/print.h>
+#include <lib/string.h>
+
+#ifdef KERNEL_TRACE
+
+trace_record_t trace_buffer[TRACE_BUFFER_SIZE];
+
+/** Number of records ever stored (the ring keeps the last ones). */
+unative_t trace_position = 0;
+
+/** Names of recently created threads (slot is selected by thread id). */
+static struct {
+    unative_t thread_id;
+    char name[THREAD_NAME_MAX_LENGTH + 1];
+} trace_names[TRACE_NAMES];
+
+static const char* trace_event_names[] = {
+    [TRACE_CREATE] = "create",
+    [TRACE_SWITCH_IN] = "in",
+    [TRACE_SWITCH_OUT] = "out",
+    [TRACE_SUSPEND] = "suspend",
+    [TRACE_WAKEUP] = "wakeup",
+    [TRACE_FINISH] = "finish",
+};
+
+/** Record thread creation and remember its name for the dump.
+ *
+ * Thread ids are never reused (unlike thread_t addresses), so the name
+ * can be printed even if the thread was already joined.
+ *
+ * @param thread Newly created thread.
+ */
+void trace_thread_created(thread_t* thread) {
+    size_t slot = thread->id % TRACE_NAMES;
+    trace_names[slot].thread_id = thread->id;
+    strncpy(trace_names[slot].name, thread->name, THREAD_NAME_MAX_LENGTH + 1);
+
+    thread_t* creator = thread_get_current();
+    trace_record(TRACE_CREATE, thread, (creator == NULL) ? 0 : creator->id);
+}
+
+/** Drop all recorded events. */
+void trace_reset(void) {
+    trace_position = 0;
+}
+
+/** Get number of records available (at most TRACE_BUFFER_SIZE). */
+size_t trace_get_count(void) {
+    return (trace_position < TRACE_BUFFER_SIZE) ? trace_position : TRACE_BUFFER_SIZE;
+}
+
+/** Get a record, index 0 is the oldest available one.
+ *
+ * @param index Record index, smaller than trace_get_count().
+ */
+trace_record_t* trace_get(size_t index) {
+    assert(index < trace_get_count());
+
+    unative_t position = trace_position - trace_get_count() + index;
+    return &trace_buffer[position & (TRACE_BUFFER_SIZE - 1)];
+}
+
+/** Print all available records (oldest first) for tools/trace.py.
+ *
+ * Printing does not switch threads so the dump itself records nothing.
+ * Each line starts with "[trace] ".
+ *
+ * @param out Where to print (e.g. a memory buffer sink).
+ */
+void trace_dump_to(print_sink_t* out) {
+    size_t count = trace_get_count();
+    unative_t position = trace_position;
+
+    fprintk(out, "[trace] begin %u %u\n", count, position - count);
+    for (size_t i = 0; i < TRACE_NAMES; i++) {
+        if (trace_names[i].name[0] != '\0') {
+            fprintk(out, "[trace] thread %u %s\n", trace_names[i].thread_id, trace_names[i].name);
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        trace_record_t* record = &trace_buffer[(position - count + i) & (TRACE_BUFFER_SIZE - 1)];
+        fprintk(out, "[trace] %u %s %u %u\n", record->timestamp,
+                trace_event_names[record->event], record->thread_id, record->arg);
+    }
+    fprintk(out, "[trace] end\n");
+}
+
+/** Print all available records to the console. */
+void trace_dump(void) {
+    trace_dump_to(printk_get_sink());
+}
+
+#endif
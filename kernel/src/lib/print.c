@@ -6,185 +6,538 @@
 #include <drivers/printer.h>
 #include <lib/print.h>
 #include <lib/stdarg.h>
+#include <proc/scheduler.h>
 #include <proc/thread.h>
 
-#define BUFFER_SIZE 20
+/** Enough for digits of any 64-bit number in base 8 or above. */
+#define BUFFER_SIZE 24
 
-/** Shifts string to the right.
+#ifdef KERNEL_PRINTK_BUFFERED
+
+/** Size of the log ring (must be a power of two). */
+#define LOG_BUFFER_SIZE 4096
+
+/*
+ * Console output is buffered in a ring that the flusher thread drains to
+ * the console device. Until the flusher is started (and after switching
+ * to synchronous mode, e.g. on panic) characters go directly to the device.
+ *
+ * Threads are switched only cooperatively and printk never switches, so
+ * the ring needs no locking. Positions are free-running counters.
+ */
+static char log_buffer[LOG_BUFFER_SIZE];
+static size_t log_head = 0;
+static size_t log_tail = 0;
+static bool log_sync = true;
+static thread_t* log_flusher = NULL;
+
+/** Output one character (to the ring or directly to the console). */
+static inline void console_putchar(char c) {
+    if (log_sync) {
+        printer_putchar(c);
+        return;
+    }
+    if (log_tail - log_head == LOG_BUFFER_SIZE) {
+        // Do not lose output, the caller pays for the flush instead.
+        printk_flush();
+    }
+    log_buffer[log_tail & (LOG_BUFFER_SIZE - 1)] = c;
+    log_tail++;
+}
+
+#else
+
+static inline void console_putchar(char c) {
+    printer_putchar(c);
+}
+
+#endif
+
+/** Output one character to a sink. */
+static inline void sink_putchar(print_sink_t* sink, char c) {
+    sink->putchar(sink, c);
+    sink->length++;
+}
+
+static void console_sink_putchar(print_sink_t* sink, char c) {
+    console_putchar(c);
+}
+
+static void buffer_sink_putchar(print_sink_t* sink, char c) {
+    print_buffer_sink_t* buffer_sink = (print_buffer_sink_t*)sink;
+    // Keep the last byte for the terminating zero, count the rest.
+    if (sink->length + 1 < buffer_sink->size) {
+        buffer_sink->buffer[sink->length] = c;
+    }
+}
+
+/** Sink of printk (the length is not really useful there). */
+static print_sink_t console_sink = {
+    .putchar = console_sink_putchar,
+    .length = 0,
+};
+
+/** Maximum number of digits of uint32_t (in base 2). */
+#define UINT32_MAX_DIGITS 32
+
+static const char digits_lower[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+static const char digits_upper[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+/** All two-digit decimal numbers, "00" to "99". */
+static const char decimal_pairs[200] = {
+    '0', '0', '0', '1', '0', '2', '0', '3', '0', '4',
+    '0', '5', '0', '6', '0', '7', '0', '8', '0', '9',
+    '1', '0', '1', '1', '1', '2', '1', '3', '1', '4',
+    '1', '5', '1', '6', '1', '7', '1', '8', '1', '9',
+    '2', '0', '2', '1', '2', '2', '2', '3', '2', '4',
+    '2', '5', '2', '6', '2', '7', '2', '8', '2', '9',
+    '3', '0', '3', '1', '3', '2', '3', '3', '3', '4',
+    '3', '5', '3', '6', '3', '7', '3', '8', '3', '9',
+    '4', '0', '4', '1', '4', '2', '4', '3', '4', '4',
+    '4', '5', '4', '6', '4', '7', '4', '8', '4', '9',
+    '5', '0', '5', '1', '5', '2', '5', '3', '5', '4',
+    '5', '5', '5', '6', '5', '7', '5', '8', '5', '9',
+    '6', '0', '6', '1', '6', '2', '6', '3', '6', '4',
+    '6', '5', '6', '6', '6', '7', '6', '8', '6', '9',
+    '7', '0', '7', '1', '7', '2', '7', '3', '7', '4',
+    '7', '5', '7', '6', '7', '7', '7', '8', '7', '9',
+    '8', '0', '8', '1', '8', '2', '8', '3', '8', '4',
+    '8', '5', '8', '6', '8', '7', '8', '8', '8', '9',
+    '9', '0', '9', '1', '9', '2', '9', '3', '9', '4',
+    '9', '5', '9', '6', '9', '7', '9', '8', '9', '9',
+};
+
+/** Convert number to digits, writing them backwards.
  *
- * WARNING: Does not check boundries of the string!
+ * The digits are produced in a single pass from the least significant one.
+ * Decimal numbers are converted two digits at a time (division by the
+ * constant 100 is turned into multiplication by the compiler), powers of two
+ * are converted with shifts and masks only.
  *
- * @param strstart Start of the string.
- * @param strend End of the string, pointer to one char past the last char.
- * @param shiftsize Size of the shift.
+ * @param n Number to convert.
+ * @param base Base of the conversion (2 to 36).
+ * @param capitalize Whether to use upper-case letters for digits above 9.
+ * @param end Pointer past the last digit (nothing is written there).
+ * @return Pointer to the first (most significant) digit.
  */
-static inline void shift_str_right(char* strstart, char* strend,
-        size_t shiftsize);
+static char* format_uint32(uint32_t n, base_t base, bool capitalize,
+        char* end);
 
-/** Fills given string with given char.
+/** Convert 64-bit number to digits, writing them backwards.
  *
- * WARNING: Does not check boundries of the string!
+ * Numbers that fit into 32 bits are converted by format_uint32(), decimal
+ * numbers are split into 9-digit chunks so that the digits themselves are
+ * produced by 32-bit arithmetic and powers of two use shifts and masks.
  *
- * @param strstart Pointer to the begining of the string to fill.
- * @param strend Pointer past the end of the string to fill.
- * @param fillchar Character to fill the string with.
+ * @param n Number to convert.
+ * @param base Base of the conversion (2 to 36).
+ * @param capitalize Whether to use upper-case letters for digits above 9.
+ * @param end Pointer past the last digit (nothing is written there).
+ * @return Pointer to the first (most significant) digit.
  */
-static inline void fill(char* strstart, char* strend, char fillchar);
+static char* format_uint64(unsigned long long n, base_t base, bool capitalize,
+        char* end);
 
-/** Get the order of the number i.e. number of digits according to given base.
- * @param n Number to process.
- * @param base Compute order according to this base.
+/*
+ * Conversion specification is parsed with the help of two tables indexed by
+ * the character: flags and conversions. Anything that is not found there is
+ * either width, precision or length (which are handled directly).
+ *
+ * %[flags][width][.precision][length]conversion
+ *
+ * flags: '-' (left-justify), '0' (pad with zeroes), '+' and ' ' (sign
+ *        of non-negative numbers)
+ * width, precision: decimal number or '*' (taken from the arguments)
+ * length: 'l' (no-op as long has 32 bits), 'z' (same) and 'll' (64 bits)
  */
-static inline size_t get_order(uint32_t n, base_t base);
+
+#define FLAG_LEFT 0x01
+#define FLAG_ZERO 0x02
+#define FLAG_PLUS 0x04
+#define FLAG_SPACE 0x08
+
+static const uint8_t format_flags[128] = {
+    ['-'] = FLAG_LEFT,
+    ['0'] = FLAG_ZERO,
+    ['+'] = FLAG_PLUS,
+    [' '] = FLAG_SPACE,
+};
+
+typedef enum {
+    CONVERSION_INVALID = 0,
+    CONVERSION_INTEGER,
+    CONVERSION_CHAR,
+    CONVERSION_STRING,
+    CONVERSION_POINTER,
+    CONVERSION_PERCENT,
+} conversion_kind_t;
+
+typedef struct {
+    uint8_t kind;
+    uint8_t base;
+    bool is_signed;
+    bool capitalize;
+} conversion_t;
+
+static const conversion_t conversions[128] = {
+    ['d'] = { CONVERSION_INTEGER, 10, true, false },
+    ['i'] = { CONVERSION_INTEGER, 10, true, false },
+    ['u'] = { CONVERSION_INTEGER, 10, false, false },
+    ['o'] = { CONVERSION_INTEGER, 8, false, false },
+    ['x'] = { CONVERSION_INTEGER, 16, false, false },
+    ['X'] = { CONVERSION_INTEGER, 16, false, true },
+    ['c'] = { CONVERSION_CHAR, 0, false, false },
+    ['s'] = { CONVERSION_STRING, 0, false, false },
+    ['p'] = { CONVERSION_POINTER, 16, false, false },
+    ['%'] = { CONVERSION_PERCENT, 0, false, false },
+};
+
+/** Parsed conversion specification. */
+typedef struct {
+    unsigned int flags;
+    int width;
+    /** Minimum number of digits (maximum length for strings), -1 if unset. */
+    int precision;
+    bool is_long_long;
+    const conversion_t* conversion;
+} format_spec_t;
 
 /** Print given integer.
- * In case of buffer overflow assert fails.
- * @param n Number to print.
- * @param is_signed Is the number signed?
- * @param base Base in which the number should be printed.
- * @param has_width Is width specifier set?
- * @param min_width Minimal width specifier?
- * @param capitalize Should the whole string be run through to_upper funciton?
- * @param buf Fixed size buffer to store the string in.
+ * @param out Where to print.
+ * @param n Number to print (sign-extended to 64 bits if signed).
+ * @param spec Format specification (base, sign, padding etc.).
+ * @param buf Fixed size buffer to store the digits in.
  */
-static void print_integer(uint32_t n, bool is_signed, base_t base,
-        bool has_width, int min_width, bool capitalize, char buf[BUFFER_SIZE]);
+static void print_integer(print_sink_t* out, unsigned long long n,
+        const format_spec_t* spec, char buf[BUFFER_SIZE]);
+
+/** Print given string, honouring width and precision.
+ * @param out Where to print.
+ * @param s String to print.
+ * @param spec Format specification.
+ */
+static void print_string(print_sink_t* out, const char* s,
+        const format_spec_t* spec);
 
 /** Prints the pointer.
  * Format: 0x<hexa_value_of_pointer>
- * In case of buffer overflow assert fails.
+ * @param out Where to print.
  * @param p Pointer value to print.
  * @param buf Fixed size buffer to store the string in.
  */
-static void print_pointer(void* p, char buf[BUFFER_SIZE]);
+static void print_pointer(print_sink_t* out, void* p, char buf[BUFFER_SIZE]);
 
 /** Prints list
  * Format: for empty: "[empty]"
  *         non empty: "[#item_count: 0th-link_t_address-1st-link_t_address...]
+ * @param out Where to print.
  * @param list List to print.
  * @param buf Fixed size buffer to store individual poitners and numbers.
  *            Buffer stores only single pointer / number at once. It doesn't
  *            store whole list. Use similar buffer as in print_pointer or
  *            print_integer.
  */
-static void print_list(list_t* list, char buf[BUFFER_SIZE]);
+static void print_list(print_sink_t* out, list_t* list, char buf[BUFFER_SIZE]);
 
 /** Prints thread info
  * Format: // TODO
- * @param list List to print.
+ * @param out Where to print.
+ * @param thread Thread to print.
  */
-static void print_thread(thread_t* thread);
-
-/** Implementation of uint32_t_to_string.
- * Converts uint32_t number n with given order and base to string stored in dst
- * which does have sufficient memory allocated w.r.t. order.
- * Order has to be valid w.r.t. chosen base.
- * @param n number to convert
- * @param buf pointer to having enought alocated memory
- * @param order of n w.r.t. base
- * @param base of the converion
- */
-static void uint32_to_str_impl(uint32_t n, char* buf, int order,
-        int base);
+static void print_thread(print_sink_t* out, thread_t* thread);
 
 void fputs(const char* s) {
     while (*s != '\0') {
-        printer_putchar(*s);
+        console_putchar(*s);
         s++;
     }
 }
 
 void puts(const char* s) {
     fputs(s);
-    printer_putchar('\n');
+    console_putchar('\n');
 }
 
-void printk(const char* format, ...) {
-    va_list args;
-    va_start(args, format);
+#ifdef KERNEL_PRINTK_BUFFERED
+
+/** Write the ring to the console device (a simple loop without calls). */
+static inline void log_drain(void) {
+    while (log_head != log_tail) {
+        printer_putchar(log_buffer[log_head & (LOG_BUFFER_SIZE - 1)]);
+        log_head++;
+    }
+}
+
+void printk_flush(void) {
+    log_drain();
+}
+
+void printk_flush_on_exception(void) {
+    // A fault inside the flush itself must not loop forever.
+    static bool flushing = false;
+    if (flushing) {
+        return;
+    }
+    flushing = true;
+    log_drain();
+}
+
+void printk_set_sync(bool sync) {
+    if (sync) {
+        printk_flush();
+    }
+    // Without the flusher nobody would drain the buffer.
+    log_sync = sync || (log_flusher == NULL);
+}
 
-    char* endptr;
-    bool has_width = false;
-    unsigned min_width = 0;
+static void* log_flusher_thread(void* ignored) {
+    while (true) {
+        printk_flush();
+        thread_suspend();
+    }
+    return NULL;
+}
+
+errno_t printk_start_flusher(void) {
+    assert(log_flusher == NULL);
+
+    errno_t err = thread_create(&log_flusher, log_flusher_thread, NULL,
+            THREAD_FLAG_STACK_SMALL, "[PRINTK]");
+    if (err != EOK) {
+        log_flusher = NULL;
+        return err;
+    }
+    log_sync = false;
+    return EOK;
+}
+
+void printk_poll_flusher(void) {
+    if ((log_flusher == NULL) || (log_head == log_tail)) {
+        return;
+    }
+    // The flusher must not wake itself: it would never let the scheduler
+    // find out that nothing else is ready.
+    if ((log_flusher->state != SUSPENDED) || (thread_get_current() == log_flusher)) {
+        return;
+    }
+    // Low priority: run only when no other thread waits for the processor
+    // (the running one may still be ready, e.g. when it polls by yielding)
+    // or when the ring is getting full.
+    if ((scheduler_get_ready_count() == 0)
+            || (log_tail - log_head >= LOG_BUFFER_SIZE / 2)) {
+        thread_wakeup(log_flusher);
+    }
+}
+
+#else
+
+void printk_flush(void) {
+}
+
+void printk_flush_on_exception(void) {
+}
+
+void printk_set_sync(bool sync) {
+}
+
+errno_t printk_start_flusher(void) {
+    return ENOIMPL;
+}
 
-    base_t base;
-    bool is_signed = false, capitalize = false;
+void printk_poll_flusher(void) {
+}
+
+#endif
+
+/** Print given number of copies of a character. */
+static void print_padding(print_sink_t* out, char c, int count) {
+    for (int i = 0; i < count; i++) {
+        sink_putchar(out, c);
+    }
+}
+
+/** Parse decimal number or '*' in a conversion specification.
+ *
+ * @param cp Position in the format, updated past the number.
+ * @param args Arguments to take the value of '*' from.
+ * @return Parsed value.
+ */
+static int parse_number(const char** cp, va_list* args) {
+    if (**cp == '*') {
+        (*cp)++;
+        return va_arg(*args, int);
+    }
+    int value = 0;
+    while ((**cp >= '0') && (**cp <= '9')) {
+        value = value * 10 + (**cp - '0');
+        (*cp)++;
+    }
+    return value;
+}
 
+/** Print formatted output to a sink (see printk for supported formats).
+ *
+ * @param out Where to print.
+ * @param format printf-style formatting string.
+ * @param args Arguments for the format.
+ */
+static void format_to_sink(print_sink_t* out, const char* format, va_list ap) {
     char buf[BUFFER_SIZE];
 
+    // Own copy so that parse_number() can take its address.
+    va_list args;
+    va_copy(args, ap);
+
     for (const char* cp = format; *cp != '\0'; ++cp) {
         if (*cp != '%') {
-            printer_putchar(*cp);
+            sink_putchar(out, *cp);
             continue;
         }
-        if (*(++cp) == '\0') {
-            assert(false);
-        }
+        cp++;
 
-        // Check for length specifier.
-        min_width = strtol(cp, &endptr);
-        has_width = (cp != endptr);
-        cp = endptr;
+        format_spec_t spec = { .flags = 0, .width = 0, .precision = -1 };
 
-        switch (*cp) {
-        case 'c':
+        while (((uint8_t)*cp < 128) && (format_flags[(uint8_t)*cp] != 0)) {
+            spec.flags |= format_flags[(uint8_t)*cp];
+            cp++;
+        }
+        spec.width = parse_number(&cp, &args);
+        if (spec.width < 0) {
+            // Negative width from '*' means left-justify.
+            spec.flags |= FLAG_LEFT;
+            spec.width = -spec.width;
+        }
+        if (*cp == '.') {
+            cp++;
+            spec.precision = parse_number(&cp, &args);
+        }
+        if ((*cp == 'l') || (*cp == 'z')) {
+            cp++;
+            if (*cp == 'l') {
+                spec.is_long_long = true;
+                cp++;
+            }
+        }
+
+        if (((uint8_t)*cp >= 128) || (conversions[(uint8_t)*cp].kind == CONVERSION_INVALID)) {
+            assert(false);
+            break;
+        }
+        spec.conversion = &conversions[(uint8_t)*cp];
+
+        switch (spec.conversion->kind) {
+        case CONVERSION_INTEGER:
+            if (spec.is_long_long) {
+                print_integer(out, va_arg(args, unsigned long long), &spec, buf);
+            } else if (spec.conversion->is_signed) {
+                // Sign-extend so that the number stays negative.
+                print_integer(out, (long long)va_arg(args, int32_t), &spec, buf);
+            } else {
+                print_integer(out, va_arg(args, uint32_t), &spec, buf);
+            }
+            break;
+        case CONVERSION_CHAR: {
             // Use int instead of char due to promotion.
-            printer_putchar(va_arg(args, int));
+            char c = va_arg(args, int);
+            if (!(spec.flags & FLAG_LEFT)) {
+                print_padding(out, ' ', spec.width - 1);
+            }
+            sink_putchar(out, c);
+            if (spec.flags & FLAG_LEFT) {
+                print_padding(out, ' ', spec.width - 1);
+            }
             break;
-        case 'd':
-            is_signed = true;
-            base = 10;
-            capitalize = false;
-            print_integer((uint32_t)va_arg(args, int32_t), is_signed, base,
-                    has_width, min_width, capitalize, buf);
+        }
+        case CONVERSION_STRING:
+            print_string(out, va_arg(args, const char*), &spec);
             break;
-        case 'p':
+        case CONVERSION_POINTER:
             switch (*(++cp)) {
             case 'L':
-                print_list(va_arg(args, list_t*), buf);
+                print_list(out, va_arg(args, list_t*), buf);
                 break;
             case 'T':
-                print_thread(va_arg(args, thread_t*));
+                print_thread(out, va_arg(args, thread_t*));
                 break;
             default:
                 --cp;
-                print_pointer(va_arg(args, void*), buf);
+                print_pointer(out, va_arg(args, void*), buf);
             }
             break;
-        case 's':
-            fputs(va_arg(args, const char*));
-            break;
-        case 'u':
-            is_signed = false;
-            base = 10;
-            capitalize = false;
-            print_integer(va_arg(args, uint32_t), is_signed, base, has_width,
-                    min_width, capitalize, buf);
-            break;
-        case 'X':
-            is_signed = false;
-            base = 16;
-            capitalize = true;
-            print_integer(va_arg(args, uint32_t), is_signed, base, has_width,
-                    min_width, capitalize, buf);
+        case CONVERSION_PERCENT:
+            sink_putchar(out, '%');
             break;
-        case 'x':
-            is_signed = false;
-            base = 16;
-            capitalize = false;
-            print_integer(va_arg(args, uint32_t), is_signed, base, has_width,
-                    min_width, capitalize, buf);
-            break;
-        case '%':
-            printer_putchar('%');
-            break;
-        default:
-            assert(false);
         }
     }
     va_end(args);
 }
 
+void printk(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    format_to_sink(&console_sink, format, args);
+    va_end(args);
+}
+
+print_sink_t* printk_get_sink(void) {
+    return &console_sink;
+}
+
+void vprintk(const char* format, va_list args) {
+    format_to_sink(&console_sink, format, args);
+}
+
+size_t fprintk(print_sink_t* sink, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    size_t length = vfprintk(sink, format, args);
+    va_end(args);
+    return length;
+}
+
+size_t vfprintk(print_sink_t* sink, const char* format, va_list args) {
+    size_t start = sink->length;
+    format_to_sink(sink, format, args);
+    return sink->length - start;
+}
+
+void print_buffer_sink_init(print_buffer_sink_t* sink, char* buffer, size_t size) {
+    sink->base.putchar = buffer_sink_putchar;
+    sink->base.length = 0;
+    sink->buffer = buffer;
+    sink->size = size;
+    if (size > 0) {
+        buffer[0] = '\0';
+    }
+}
+
+void print_buffer_sink_terminate(print_buffer_sink_t* sink) {
+    if (sink->size == 0) {
+        return;
+    }
+    size_t end = sink->base.length;
+    if (end >= sink->size) {
+        end = sink->size - 1;
+    }
+    sink->buffer[end] = '\0';
+}
+
+size_t snprintk(char* buffer, size_t size, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    size_t length = vsnprintk(buffer, size, format, args);
+    va_end(args);
+    return length;
+}
+
+size_t vsnprintk(char* buffer, size_t size, const char* format, va_list args) {
+    print_buffer_sink_t sink;
+    print_buffer_sink_init(&sink, buffer, size);
+    format_to_sink(&sink.base, format, args);
+    print_buffer_sink_terminate(&sink);
+    return sink.base.length;
+}
+
 int toupper(int c) {
     if (c >= 'a' && c <= 'z') {
         c -= 'a' - 'A';
@@ -193,30 +546,35 @@ int toupper(int c) {
 }
 
 int uint32_to_str(uint32_t n, base_t base, char* buf, size_t buflen) {
-    const size_t order = get_order(n, base);
+    char digits[UINT32_MAX_DIGITS];
+    char* end = digits + UINT32_MAX_DIGITS;
+    char* start = format_uint32(n, base, false, end);
+
+    size_t order = end - start;
     if (order > buflen) {
         return -1;
     }
-    uint32_to_str_impl(n, buf, order, base);
+    for (size_t i = 0; i < order; i++) {
+        buf[i] = start[i];
+    }
+    if (order < buflen) {
+        buf[order] = '\0';
+    }
     return order;
 }
 
 int int32_to_str(int32_t n, base_t base, char* buf, size_t buflen) {
-    bool is_negative = false;
-    if (n < 0) {
-        is_negative = true;
-        n *= (-1); // make n possitive
+    if (n >= 0) {
+        return uint32_to_str(n, base, buf, buflen);
     }
-
-    const size_t order = get_order(n, base);
-    if (order + is_negative > buflen) {
+    if (buflen == 0) {
         return -1;
     }
-    if (is_negative) {
-        buf[0] = '-';
-    }
-    uint32_to_str_impl((uint32_t)n, buf + is_negative, order, base);
-    return order + is_negative;
+
+    // Negate as unsigned so that INT32_MIN works too.
+    buf[0] = '-';
+    int order = uint32_to_str(-(uint32_t)n, base, buf + 1, buflen - 1);
+    return (order == -1) ? -1 : order + 1;
 }
 
 long int strtol(const char* nptr, char** endptr) {
@@ -233,110 +591,195 @@ long int strtol(const char* nptr, char** endptr) {
     return i;
 }
 
-char* strncpy(char* dest, const char* src, size_t n) {
-    size_t i;
-    for (i = 0; i < n && src[i] != '\0'; ++i) {
-        dest[i] = src[i];
+static char* format_uint32(uint32_t n, base_t base, bool capitalize,
+        char* end) {
+    char* p = end;
+
+    if (base == 10) {
+        while (n >= 100) {
+            uint32_t pair = (n % 100) * 2;
+            n /= 100;
+            *--p = decimal_pairs[pair + 1];
+            *--p = decimal_pairs[pair];
+        }
+        if (n >= 10) {
+            *--p = decimal_pairs[n * 2 + 1];
+            *--p = decimal_pairs[n * 2];
+        } else {
+            *--p = '0' + n;
+        }
+        return p;
     }
-    for ( ; i < n; ++i) {
-        dest[i] = '\0';
+
+    const char* digits = capitalize ? digits_upper : digits_lower;
+
+    if ((base & (base - 1)) == 0) {
+        unsigned int shift = 1;
+        while ((1U << shift) != base) {
+            shift++;
+        }
+        do {
+            *--p = digits[n & (base - 1)];
+            n >>= shift;
+        } while (n != 0);
+        return p;
     }
-    return dest;
+
+    do {
+        *--p = digits[n % base];
+        n /= base;
+    } while (n != 0);
+    return p;
 }
 
-static inline void shift_str_right(char* strstart, char* strend,
-        size_t shiftsize) {
-    for (char* cp = strend - 1; cp >= strstart; --cp) {
-        *(cp + shiftsize) = *cp;
+static char* format_uint64(unsigned long long n, base_t base, bool capitalize,
+        char* end) {
+    if ((n >> 32) == 0) {
+        return format_uint32((uint32_t)n, base, capitalize, end);
     }
-}
 
-static inline void fill(char* strstart, char* strend, char fillchar) {
-    for (char* cp = strstart; cp < strend; ++cp) {
-        *cp = fillchar;
+    if (base == 10) {
+        // At most three chunks as 2^64 < 10^27.
+        const uint32_t chunk = 1000000000;
+        unsigned long long upper = n / chunk;
+        char* p = format_uint32((uint32_t)(n - upper * chunk), 10, false, end);
+        while (p > end - 9) {
+            *--p = '0';
+        }
+        return format_uint64(upper, 10, false, p);
+    }
+
+    const char* digits = capitalize ? digits_upper : digits_lower;
+    char* p = end;
+
+    if ((base & (base - 1)) == 0) {
+        // Shifts and masks only, no 64-bit division (see format_uint32).
+        unsigned int shift = 1;
+        while ((1U << shift) != base) {
+            shift++;
+        }
+        do {
+            *--p = digits[(uint32_t)n & (base - 1)];
+            n >>= shift;
+        } while (n != 0);
+        return p;
     }
-}
 
-static inline size_t get_order(uint32_t n, base_t base) {
-    size_t order = 0;
     do {
-        ++order;
+        *--p = digits[n % base];
         n /= base;
     } while (n != 0);
-    return order;
+    return p;
 }
 
-static void print_integer(uint32_t n, bool is_signed, base_t base,
-        bool has_width, int min_width, bool capitalize, char buf[BUFFER_SIZE]) {
-    if (min_width > BUFFER_SIZE) {
-        assert(false);
+static void print_integer(print_sink_t* out, unsigned long long n,
+        const format_spec_t* spec, char buf[BUFFER_SIZE]) {
+    const conversion_t* conversion = spec->conversion;
+
+    char sign = '\0';
+    if (conversion->is_signed && ((long long)n < 0)) {
+        sign = '-';
+        n = -n;
+    } else if (conversion->is_signed && (spec->flags & FLAG_PLUS)) {
+        sign = '+';
+    } else if (conversion->is_signed && (spec->flags & FLAG_SPACE)) {
+        sign = ' ';
     }
 
-    int width;
-    if (is_signed) {
-        width = int32_to_str(n, base, buf, BUFFER_SIZE);
-    } else {
-        width = uint32_to_str(n, base, buf, BUFFER_SIZE);
+    char* end = buf + BUFFER_SIZE;
+    char* start = format_uint64(n, conversion->base, conversion->capitalize, end);
+    int digit_count = end - start;
+    if ((spec->precision == 0) && (n == 0)) {
+        digit_count = 0;
     }
-    if (width == -1) {
-        assert(false);
+
+    int zeroes = (spec->precision > digit_count) ? spec->precision - digit_count : 0;
+    int length = (sign != '\0') + zeroes + digit_count;
+    int padding = (spec->width > length) ? spec->width - length : 0;
+
+    // Zero flag is ignored with precision or left-justification.
+    if ((spec->flags & FLAG_ZERO) && !(spec->flags & FLAG_LEFT) && (spec->precision < 0)) {
+        zeroes += padding;
+        padding = 0;
     }
 
-    if (has_width && width < min_width) {
-        char* one_past_end = buf + width + 1;
-        size_t shift_size = min_width - width;
-        shift_str_right(buf, one_past_end, shift_size);
+    if (!(spec->flags & FLAG_LEFT)) {
+        print_padding(out, ' ', padding);
+    }
+    if (sign != '\0') {
+        sink_putchar(out, sign);
+    }
+    print_padding(out, '0', zeroes);
+    for (int i = 0; i < digit_count; i++) {
+        sink_putchar(out, start[i]);
+    }
+    if (spec->flags & FLAG_LEFT) {
+        print_padding(out, ' ', padding);
+    }
+}
 
-        one_past_end = buf + shift_size;
-        fill(buf, one_past_end, '0');
+static void print_string(print_sink_t* out, const char* s,
+        const format_spec_t* spec) {
+    int length = 0;
+    while ((s[length] != '\0') && ((spec->precision < 0) || (length < spec->precision))) {
+        length++;
     }
+    int padding = (spec->width > length) ? spec->width - length : 0;
 
-    if (capitalize) {
-        for (char* cp = buf; *cp != '\0'; ++cp) {
-            *cp = toupper(*cp);
-        }
+    if (!(spec->flags & FLAG_LEFT)) {
+        print_padding(out, ' ', padding);
+    }
+    for (int i = 0; i < length; i++) {
+        sink_putchar(out, s[i]);
+    }
+    if (spec->flags & FLAG_LEFT) {
+        print_padding(out, ' ', padding);
     }
-    fputs(buf);
 }
 
-static void print_pointer(void* p, char buf[BUFFER_SIZE]) {
-    fputs("0x");
-    bool is_signed = false, has_width = false, capitalize = false;
-    base_t base = 16;
-    size_t min_width = 0;
-    print_integer((uintptr_t)p, is_signed, base, has_width, min_width,
-            capitalize, buf);
+static void print_pointer(print_sink_t* out, void* p, char buf[BUFFER_SIZE]) {
+    format_spec_t spec = {
+        .flags = 0,
+        .width = 0,
+        .precision = -1,
+        .conversion = &conversions['p'],
+    };
+    sink_putchar(out, '0');
+    sink_putchar(out, 'x');
+    print_integer(out, (uintptr_t)p, &spec, buf);
 }
 
-static void print_list(list_t* list, char buf[BUFFER_SIZE]) {
+static void print_list(print_sink_t* out, list_t* list, char buf[BUFFER_SIZE]) {
     const size_t size = list_get_size(list);
     if (size == 0) {
-        print_pointer(list, buf);
-        fputs("[empty]");
+        fprintk(out, "%p[empty]", list);
         return;
     }
 
     link_t* it = list->head.next;
-    printk("%p[%u: %p", list, size, it);
+    fprintk(out, "%p[%u: %p", list, size, it);
 
     if (size > 1) {
         for (it = it->next; it != &list->head; it = it->next) {
-            printer_putchar('-');
-            print_pointer(it, buf);
+            sink_putchar(out, '-');
+            print_pointer(out, it, buf);
         }
     }
-    printer_putchar(']');
+    sink_putchar(out, ']');
 }
 
-static void print_thread(thread_t* thread) {
-    printk("Thread[%p] %s:"
+static void print_thread(print_sink_t* out, thread_t* thread) {
+    fprintk(out, "Thread[%p] %s:"
            "\tstate: %s"
            "\tentry_func: %p"
            "\tdata: %p"
            "\tstack_top %p"
            "\tcontext: %p"
            "\tsp: %p"
-           "\tra: %p",
+           "\tra: %p"
+           "\trun: %u"
+           "\twait: %u"
+           "\tswitches: %u (%u voluntary, %u involuntary)",
            thread,
            thread->name,
            (thread->state == READY) ? "READY" :
@@ -346,20 +789,10 @@ static void print_thread(thread_t* thread) {
            thread->stack_top,
            THREAD_INITIAL_CONTEXT(thread),
            THREAD_INITIAL_CONTEXT(thread)->sp,
-           THREAD_INITIAL_CONTEXT(thread)->ra);
-}
-
-static void uint32_to_str_impl(uint32_t n, char* buf, int order,
-        int base) {
-    buf[order] = '\0';
-
-    // Represent uint in string first using digits '0'-'9' then alphabet 'a'-...
-    // according to selected base.
-    // Base should be reasonable s.t. it fits alphabet otherwise we start
-    // printing characters following 'z' whatever that is :D
-    for (int i = order - 1; i >= 0; --i) {
-        char digit = n % base;
-        buf[i] = (digit < 10) ? digit + '0' : digit - 10 + 'a';
-        n /= base;
-    }
+           THREAD_INITIAL_CONTEXT(thread)->ra,
+           thread->stats.run_cycles,
+           thread->stats.wait_cycles,
+           thread->stats.switches,
+           thread->stats.voluntary_switches,
+           thread->stats.involuntary_switches);
 }
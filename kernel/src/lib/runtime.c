@@ -2,6 +2,7 @@
 // Copyright 2019 Charles University
 
 #include <lib/runtime.h>
+#include <types.h>
 
 static inline unsigned long long ll_abs(long long a) {
     if (a < 0) {
@@ -19,6 +20,88 @@ static inline int ll_simple_sgn(long long a) {
     }
 }
 
+/** Count leading zero bits of a non-zero 32-bit number.
+ *
+ * R4000 has no clz instruction, hence the binary search.
+ */
+static inline unsigned int clz32(uint32_t x) {
+    unsigned int n = 0;
+    if (x <= 0x0000ffff) {
+        n += 16;
+        x <<= 16;
+    }
+    if (x <= 0x00ffffff) {
+        n += 8;
+        x <<= 8;
+    }
+    if (x <= 0x0fffffff) {
+        n += 4;
+        x <<= 4;
+    }
+    if (x <= 0x3fffffff) {
+        n += 2;
+        x <<= 2;
+    }
+    if (x <= 0x7fffffff) {
+        n += 1;
+    }
+    return n;
+}
+
+/** Divide 64-bit number (u1:u0) by 32-bit number v, u1 must be less than v.
+ *
+ * Long division with 16-bit digits (Knuth's algorithm D as presented
+ * in Hacker's Delight): v is first normalized so that its top bit is set,
+ * each quotient digit is then estimated with one 32-bit divu and corrected
+ * at most twice.
+ */
+static uint32_t div64_32(uint32_t u1, uint32_t u0, uint32_t v,
+        uint32_t* rem) {
+    const uint32_t base = 0x10000;
+
+    unsigned int shift = clz32(v);
+    v <<= shift;
+    uint32_t vn1 = v >> 16;
+    uint32_t vn0 = v & 0xffff;
+
+    uint32_t un32 = u1 << shift;
+    if (shift > 0) {
+        un32 |= u0 >> (32 - shift);
+    }
+    uint32_t un10 = u0 << shift;
+    uint32_t un1 = un10 >> 16;
+    uint32_t un0 = un10 & 0xffff;
+
+    uint32_t q1 = un32 / vn1;
+    uint32_t rhat = un32 - q1 * vn1;
+    while ((q1 >= base) || (q1 * vn0 > base * rhat + un1)) {
+        q1--;
+        rhat += vn1;
+        if (rhat >= base) {
+            break;
+        }
+    }
+
+    uint32_t un21 = un32 * base + un1 - q1 * v;
+
+    uint32_t q0 = un21 / vn1;
+    rhat = un21 - q0 * vn1;
+    while ((q0 >= base) || (q0 * vn0 > base * rhat + un0)) {
+        q0--;
+        rhat += vn1;
+        if (rhat >= base) {
+            break;
+        }
+    }
+
+    *rem = (un21 * base + un0 - q0 * v) >> shift;
+    return q1 * base + q0;
+}
+
+/*
+ * Note that this file must not divide 64-bit numbers itself (the compiler
+ * would call the functions below), only 32-bit divisions are used.
+ */
 static unsigned long long ull_div_and_mod(unsigned long long a,
         unsigned long long b, unsigned long long* rem) {
 
@@ -32,22 +115,51 @@ static unsigned long long ull_div_and_mod(unsigned long long a,
         return 0;
     }
 
-    int ull_size = sizeof(unsigned long long) * 8;
-    *rem = 0;
-    unsigned long long res = 0;
+    uint32_t a_hi = a >> 32;
+    uint32_t b_hi = b >> 32;
+    uint32_t b_lo = (uint32_t)b;
 
-    for (int steps = ull_size; steps > 0; steps--) {
-        *rem = ((*rem) << 1) | ((a >> (ull_size - 1)) & 0x1);
-        res <<= 1;
+    // Powers of two are a mask and a shift.
+    if ((b & (b - 1)) == 0) {
+        unsigned int shift = (b_hi != 0) ? 63 - clz32(b_hi) : 31 - clz32(b_lo);
+        *rem = a & (b - 1);
+        return a >> shift;
+    }
 
-        if (*rem >= b) {
-            *rem -= b;
-            res |= 0x1;
-        }
-        a <<= 1;
+    // Both fit into 32 bits: plain divu.
+    if (a_hi == 0) {
+        uint32_t q = (uint32_t)a / b_lo;
+        *rem = (uint32_t)a - q * b_lo;
+        return q;
+    }
+
+    // Divisor fits into 32 bits (e.g. timestamp divided by frequency).
+    if (b_hi == 0) {
+        uint32_t q_hi = a_hi / b_lo;
+        uint32_t r;
+        uint32_t q_lo = div64_32(a_hi - q_hi * b_lo, (uint32_t)a, b_lo, &r);
+        *rem = r;
+        return ((unsigned long long)q_hi << 32) | q_lo;
     }
 
-    return res;
+    // Quotient fits into 32 bits: estimate it from the top 32 bits of the
+    // normalized divisor, the estimate is at most one too big or too small.
+    unsigned int shift = clz32(b_hi);
+    uint32_t b_top = (b << shift) >> 32;
+    unsigned long long a_half = a >> 1;
+    uint32_t unused_rem;
+    uint32_t q_half = div64_32(a_half >> 32, (uint32_t)a_half, b_top, &unused_rem);
+
+    unsigned long long q = ((unsigned long long)q_half << shift) >> 31;
+    if (q != 0) {
+        q--;
+    }
+    *rem = a - q * b;
+    if (*rem >= b) {
+        q++;
+        *rem -= b;
+    }
+    return q;
 }
 
 unsigned long long __udivdi3(unsigned long long a, unsigned long long b) {
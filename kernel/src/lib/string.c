@@ -0,0 +1,220 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#include <lib/string.h>
+
+/*
+ * The compiler is free to turn byte loops into calls to memset or memcpy
+ * (and it does so at -O2), that would make these functions call themselves.
+ */
+#define NO_LIBCALLS __attribute__((optimize("no-tree-loop-distribute-patterns")))
+
+/** Word that may alias anything. */
+typedef uint32_t __attribute__((may_alias)) word_t;
+
+/** Word at possibly unaligned address (compiled into lwl/lwr). */
+typedef struct {
+    word_t value;
+} __attribute__((packed, may_alias)) unaligned_word_t;
+
+#define WORD_SIZE sizeof(word_t)
+#define WORD_MASK (WORD_SIZE - 1)
+
+/** Copies shorter than this are done byte by byte. */
+#define SHORT_COPY 16
+
+#define BYTES_ONES 0x01010101U
+#define BYTES_HIGHS 0x80808080U
+
+/** Whether a word contains a zero byte. */
+static inline bool word_has_zero(uint32_t word) {
+    return ((word - BYTES_ONES) & ~word & BYTES_HIGHS) != 0;
+}
+
+static inline bool is_aligned(const void* ptr) {
+    return ((uintptr_t)ptr & WORD_MASK) == 0;
+}
+
+NO_LIBCALLS void* memcpy(void* dest, const void* src, size_t n) {
+    uint8_t* d = dest;
+    const uint8_t* s = src;
+
+    if (n >= SHORT_COPY) {
+        while (!is_aligned(d)) {
+            *d++ = *s++;
+            n--;
+        }
+
+        if (is_aligned(s)) {
+            while (n >= 4 * WORD_SIZE) {
+                word_t w0 = ((const word_t*)s)[0];
+                word_t w1 = ((const word_t*)s)[1];
+                word_t w2 = ((const word_t*)s)[2];
+                word_t w3 = ((const word_t*)s)[3];
+                ((word_t*)d)[0] = w0;
+                ((word_t*)d)[1] = w1;
+                ((word_t*)d)[2] = w2;
+                ((word_t*)d)[3] = w3;
+                d += 4 * WORD_SIZE;
+                s += 4 * WORD_SIZE;
+                n -= 4 * WORD_SIZE;
+            }
+            while (n >= WORD_SIZE) {
+                *(word_t*)d = *(const word_t*)s;
+                d += WORD_SIZE;
+                s += WORD_SIZE;
+                n -= WORD_SIZE;
+            }
+        } else {
+            while (n >= WORD_SIZE) {
+                *(word_t*)d = ((const unaligned_word_t*)s)->value;
+                d += WORD_SIZE;
+                s += WORD_SIZE;
+                n -= WORD_SIZE;
+            }
+        }
+    }
+
+    while (n > 0) {
+        *d++ = *s++;
+        n--;
+    }
+    return dest;
+}
+
+NO_LIBCALLS void* memmove(void* dest, const void* src, size_t n) {
+    uint8_t* d = dest;
+    const uint8_t* s = src;
+
+    // Copying forward is safe unless the destination starts inside the
+    // source (memcpy reads every word before it overwrites it).
+    if ((d <= s) || (d >= s + n)) {
+        return memcpy(dest, src, n);
+    }
+
+    d += n;
+    s += n;
+
+    if (n >= SHORT_COPY) {
+        while (!is_aligned(d)) {
+            *--d = *--s;
+            n--;
+        }
+        if (is_aligned(s)) {
+            while (n >= WORD_SIZE) {
+                d -= WORD_SIZE;
+                s -= WORD_SIZE;
+                *(word_t*)d = *(const word_t*)s;
+                n -= WORD_SIZE;
+            }
+        } else {
+            while (n >= WORD_SIZE) {
+                d -= WORD_SIZE;
+                s -= WORD_SIZE;
+                *(word_t*)d = ((const unaligned_word_t*)s)->value;
+                n -= WORD_SIZE;
+            }
+        }
+    }
+
+    while (n > 0) {
+        *--d = *--s;
+        n--;
+    }
+    return dest;
+}
+
+NO_LIBCALLS void* memset(void* dest, int c, size_t n) {
+    uint8_t* d = dest;
+    uint8_t byte = (uint8_t)c;
+
+    if (n >= SHORT_COPY) {
+        while (!is_aligned(d)) {
+            *d++ = byte;
+            n--;
+        }
+
+        word_t word = byte * BYTES_ONES;
+        while (n >= 4 * WORD_SIZE) {
+            ((word_t*)d)[0] = word;
+            ((word_t*)d)[1] = word;
+            ((word_t*)d)[2] = word;
+            ((word_t*)d)[3] = word;
+            d += 4 * WORD_SIZE;
+            n -= 4 * WORD_SIZE;
+        }
+        while (n >= WORD_SIZE) {
+            *(word_t*)d = word;
+            d += WORD_SIZE;
+            n -= WORD_SIZE;
+        }
+    }
+
+    while (n > 0) {
+        *d++ = byte;
+        n--;
+    }
+    return dest;
+}
+
+NO_LIBCALLS int memcmp(const void* a, const void* b, size_t n) {
+    const uint8_t* pa = a;
+    const uint8_t* pb = b;
+
+    // Skip equal words, the differing one is then compared byte by byte
+    // (which does not depend on endianness).
+    if (((uintptr_t)pa & WORD_MASK) == ((uintptr_t)pb & WORD_MASK)) {
+        while ((n > 0) && !is_aligned(pa)) {
+            if (*pa != *pb) {
+                return *pa - *pb;
+            }
+            pa++;
+            pb++;
+            n--;
+        }
+        while ((n >= WORD_SIZE) && (*(const word_t*)pa == *(const word_t*)pb)) {
+            pa += WORD_SIZE;
+            pb += WORD_SIZE;
+            n -= WORD_SIZE;
+        }
+    }
+
+    while (n > 0) {
+        if (*pa != *pb) {
+            return *pa - *pb;
+        }
+        pa++;
+        pb++;
+        n--;
+    }
+    return 0;
+}
+
+NO_LIBCALLS size_t strlen(const char* s) {
+    const char* p = s;
+
+    while (!is_aligned(p)) {
+        if (*p == '\0') {
+            return p - s;
+        }
+        p++;
+    }
+
+    // Reading the whole aligned word never crosses a page boundary.
+    while (!word_has_zero(*(const word_t*)p)) {
+        p += WORD_SIZE;
+    }
+    while (*p != '\0') {
+        p++;
+    }
+    return p - s;
+}
+
+NO_LIBCALLS char* strncpy(char* dest, const char* src, size_t n) {
+    size_t i;
+    for (i = 0; i < n && src[i] != '\0'; ++i) {
+        dest[i] = src[i];
+    }
+    memset(dest + i, 0, n - i);
+    return dest;
+}
@@ -16,6 +16,7 @@ static void* init_thread(void* ignored) {
     printk("%s: Hello, World!\n", thread_get_current()->name);
 #endif
     printk("\nHalt.\n");
+    printk_flush();
     machine_halt();
 
     return NULL;
@@ -39,6 +40,10 @@ void kernel_main(void) {
     errno_t err = thread_create(&main_thread, init_thread, NULL, 0, "[INIT]");
     panic_if(err != EOK, "init thread creation failed (%d: %s)", err, errno_as_str(err));
 
+    // Buffering is only an optimization, output stays synchronous when
+    // the flusher is not available.
+    printk_start_flusher();
+
     // Switch to the first thread.
     scheduler_schedule_next();
 
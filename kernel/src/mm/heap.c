@@ -131,8 +131,10 @@ void kfree(void* ptr) {
 
     list_prepend(&free_blocks, &header->free_link);
 
-    compact(header->link.prev, &header->link);
+    // Merge the following block first, merging with the preceding one
+    // unlinks this header.
     compact(&header->link, header->link.next);
+    compact(header->link.prev, &header->link);
 }
 
 
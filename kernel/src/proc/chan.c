@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#include <debug.h>
+#include <mm/heap.h>
+#include <proc/chan.h>
+
+/*
+ * Parked senders keep their message in waiter_t.data, parked receivers get
+ * their message in waiter_t.data. Buffered messages and parked receivers
+ * never exist at the same time (and neither do free buffer space and parked
+ * senders) so each operation checks only one wait queue.
+ */
+
+static inline void buffer_put(chan_t* chan, void* message) {
+    assert(chan->count < chan->capacity);
+
+    size_t tail = chan->head + chan->count;
+    if (tail >= chan->capacity) {
+        tail -= chan->capacity;
+    }
+    chan->buffer[tail] = message;
+    chan->count++;
+}
+
+static inline void* buffer_take(chan_t* chan) {
+    assert(chan->count > 0);
+
+    void* message = chan->buffer[chan->head];
+    chan->head++;
+    if (chan->head == chan->capacity) {
+        chan->head = 0;
+    }
+    chan->count--;
+    return message;
+}
+
+/** Deliver message without blocking if somebody can accept it.
+ *
+ * @retval EOK Message was handed to a receiver or buffered.
+ * @retval EBUSY Buffer is full and no receiver is waiting.
+ */
+static errno_t send_nonblocking(chan_t* chan, void* message) {
+    waiter_t* receiver = waitq_pop(&chan->receivers);
+    if (receiver != NULL) {
+        receiver->data = message;
+        waitq_wake(receiver);
+        return EOK;
+    }
+    if (chan->count < chan->capacity) {
+        buffer_put(chan, message);
+        return EOK;
+    }
+    return EBUSY;
+}
+
+/** Take message without blocking if there is any.
+ *
+ * Taking a message from the buffer frees a slot for the oldest parked
+ * sender, a rendezvous channel takes the message from the sender directly.
+ *
+ * @retval EOK Message was received.
+ * @retval EBUSY No message is available.
+ */
+static errno_t recv_nonblocking(chan_t* chan, void** message_out) {
+    waiter_t* sender = waitq_pop(&chan->senders);
+    if (chan->count > 0) {
+        *message_out = buffer_take(chan);
+        if (sender != NULL) {
+            buffer_put(chan, sender->data);
+            waitq_wake(sender);
+        }
+        return EOK;
+    }
+    if (sender != NULL) {
+        *message_out = sender->data;
+        waitq_wake(sender);
+        return EOK;
+    }
+    return EBUSY;
+}
+
+/** Create a new channel.
+ *
+ * @param chan_out Where to store pointer to the new channel.
+ * @param capacity Number of messages the channel can buffer (can be zero).
+ * @return Error code.
+ * @retval EOK Channel was created.
+ * @retval ENOMEM Not enough memory to complete the operation.
+ */
+errno_t chan_create(chan_t** chan_out, size_t capacity) {
+    chan_t* chan = kmalloc(sizeof(chan_t) + capacity * sizeof(void*));
+    if (chan == NULL) {
+        return ENOMEM;
+    }
+
+    chan->capacity = capacity;
+    chan->count = 0;
+    chan->head = 0;
+    chan->buffer = (void**)(chan + 1);
+    waitq_init(&chan->receivers);
+    waitq_init(&chan->senders);
+
+    *chan_out = chan;
+    return EOK;
+}
+
+/** Destroy a channel, buffered messages are dropped.
+ *
+ * It is a kernel bug to destroy a channel somebody waits on.
+ *
+ * @param chan Channel to destroy.
+ */
+void chan_destroy(chan_t* chan) {
+    panic_if(!waitq_is_empty(&chan->receivers) || !waitq_is_empty(&chan->senders),
+            "chan_destroy: threads are still waiting");
+    kfree(chan);
+}
+
+/** Send a message, waiting while the channel is full.
+ *
+ * @param chan Channel to send to.
+ * @param message Message to send.
+ */
+void chan_send(chan_t* chan, void* message) {
+    if (send_nonblocking(chan, message) == EOK) {
+        return;
+    }
+
+    // The receiver takes the message from our waiter and wakes us.
+    waiter_t waiter;
+    waiter.data = message;
+    waitq_sleep(&chan->senders, &waiter);
+}
+
+/** Send a message only if that does not require waiting.
+ *
+ * @param chan Channel to send to.
+ * @param message Message to send.
+ * @return Error code.
+ * @retval EOK Message was sent.
+ * @retval EBUSY Channel is full.
+ */
+errno_t chan_try_send(chan_t* chan, void* message) {
+    return send_nonblocking(chan, message);
+}
+
+/** Receive a message, waiting while the channel is empty.
+ *
+ * @param chan Channel to receive from.
+ * @return Received message.
+ */
+void* chan_recv(chan_t* chan) {
+    void* message;
+    if (recv_nonblocking(chan, &message) == EOK) {
+        return message;
+    }
+
+    // The sender stores the message into our waiter and wakes us.
+    waiter_t waiter;
+    waitq_sleep(&chan->receivers, &waiter);
+    return waiter.data;
+}
+
+/** Receive a message only if that does not require waiting.
+ *
+ * @param chan Channel to receive from.
+ * @param message_out Where to store the received message.
+ * @return Error code.
+ * @retval EOK Message was received.
+ * @retval EBUSY Channel is empty.
+ */
+errno_t chan_try_recv(chan_t* chan, void** message_out) {
+    return recv_nonblocking(chan, message_out);
+}
@@ -0,0 +1,215 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#include <debug.h>
+#include <mm/heap.h>
+#include <proc/context.h>
+#include <proc/fiber.h>
+#include <proc/thread.h>
+#include <proc/tls.h>
+
+/*
+ * A fiber switch is just a function call from the point of view of the
+ * switching fiber, so cpu_switch_context_fast is enough and the scheduler
+ * does not know about fibers at all (it sees only the kernel thread that
+ * runs them). A finished fiber cannot free its own stack, the fiber (or
+ * the kernel thread) it switches to frees it instead.
+ */
+
+static void fiber_entry_func_wrapper(void);
+
+static fiber_sched_t* fiber_get_sched(void) {
+    thread_t* thread = thread_get_current();
+    return (thread == NULL) ? NULL : thread->fiber_sched;
+}
+
+/** Free the fiber that finished right before we got the processor. */
+static inline void fiber_reap(fiber_sched_t* sched) {
+    if (sched->zombie != NULL) {
+        kfree(sched->zombie);
+        sched->zombie = NULL;
+    }
+}
+
+/** Switch to the given fiber (or back to the kernel thread when NULL).
+ *
+ * @param sched Fibers we switch among.
+ * @param stack_top_old Where to save context of the running fiber.
+ * @param next Fiber to switch to.
+ */
+static void fiber_switch_to(fiber_sched_t* sched, unative_t* stack_top_old, fiber_t* next) {
+    unative_t* stack_top_new = (next == NULL) ? &sched->root_stack_top : &next->stack_top;
+    sched->current = next;
+
+    cpu_switch_context_fast((void**)stack_top_old, (void**)stack_top_new, 1);
+
+    fiber_reap(sched);
+}
+
+/** Initialize an empty set of fibers.
+ *
+ * @param sched Set to initialize.
+ */
+void fiber_sched_init(fiber_sched_t* sched) {
+    list_init(&sched->ready);
+    sched->current = NULL;
+    sched->root_stack_top = 0;
+    sched->zombie = NULL;
+    sched->fiber_count = 0;
+}
+
+/** Create a new fiber.
+ *
+ * The fiber is appended to the ready fibers of the set, it starts running
+ * once the set is executed by fiber_run (or immediately after the running
+ * fibers when created by a fiber of a running set). Fibers are freed
+ * automatically when their entry function returns.
+ *
+ * @param fiber_out Where to store pointer to the new fiber (can be NULL).
+ * @param sched Set the fiber belongs to.
+ * @param entry Fiber entry function.
+ * @param data Data for the entry function.
+ * @param stack_size Stack size in bytes, zero selects FIBER_STACK_SIZE.
+ * @return Error code.
+ * @retval EOK Fiber was created.
+ * @retval EINVAL Stack size is smaller than FIBER_STACK_SIZE_MIN.
+ * @retval ENOMEM Not enough memory to complete the operation.
+ */
+errno_t fiber_create(fiber_t** fiber_out, fiber_sched_t* sched, fiber_func_t entry, void* data, size_t stack_size) {
+    if (stack_size == 0) {
+        stack_size = FIBER_STACK_SIZE;
+    }
+    if (stack_size < FIBER_STACK_SIZE_MIN) {
+        return EINVAL;
+    }
+    // Keep the stack top aligned to a double word as the ABI requires.
+    stack_size = (stack_size + 7) & ~7;
+
+    fiber_t* fiber = kmalloc(sizeof(fiber_t) + stack_size);
+    if (fiber == NULL) {
+        return ENOMEM;
+    }
+
+    fiber->entry_func = entry;
+    fiber->data = data;
+    fiber->stack_size = stack_size;
+    fiber->sched = sched;
+    link_init(&fiber->link);
+
+    uintptr_t stack_top = ((uintptr_t)(fiber + 1) + stack_size) & ~7;
+    context_t* context = (context_t*)(stack_top - sizeof(context_t));
+    context->sp = stack_top;
+    context->ra = (unative_t)&fiber_entry_func_wrapper;
+    context->status = 0xff01;
+    fiber->stack_top = (unative_t)context;
+
+    list_append(&sched->ready, &fiber->link);
+    sched->fiber_count++;
+
+    if (fiber_out != NULL) {
+        *fiber_out = fiber;
+    }
+    return EOK;
+}
+
+/** Execute fibers of the set in the current kernel thread.
+ *
+ * Fibers run round-robin (as they yield) until all of them have finished,
+ * then the function returns.
+ *
+ * @param sched Set of fibers to execute.
+ */
+void fiber_run(fiber_sched_t* sched) {
+    thread_t* thread = thread_get_current();
+    panic_if(thread->fiber_sched != NULL, "fiber_run: %pT already runs fibers", thread);
+
+    link_t* first = list_pop(&sched->ready);
+    if (first == NULL) {
+        return;
+    }
+
+    thread->fiber_sched = sched;
+    fiber_switch_to(sched, &sched->root_stack_top, list_item(first, fiber_t, link));
+    thread->fiber_sched = NULL;
+
+    assert(sched->fiber_count == 0);
+}
+
+/** Get the running fiber.
+ *
+ * @retval NULL Current kernel thread does not execute fibers.
+ */
+fiber_t* fiber_get_current(void) {
+    fiber_sched_t* sched = fiber_get_sched();
+    return (sched == NULL) ? NULL : sched->current;
+}
+
+/** Let the next ready fiber of the set run.
+ *
+ * Returns immediately when there is no other ready fiber (or when called
+ * outside of a fiber).
+ */
+void fiber_yield(void) {
+    fiber_sched_t* sched = fiber_get_sched();
+    if ((sched == NULL) || (sched->current == NULL)) {
+        return;
+    }
+
+    link_t* next = list_pop(&sched->ready);
+    if (next == NULL) {
+        return;
+    }
+
+    fiber_t* current = sched->current;
+    list_append(&sched->ready, &current->link);
+    fiber_switch_to(sched, &current->stack_top, list_item(next, fiber_t, link));
+}
+
+/** Switch directly to the given fiber of the same set.
+ *
+ * The running fiber takes over the position of the target among the ready
+ * fibers (see also thread_yield_to).
+ *
+ * @param fiber Fiber to switch to (must not have finished yet).
+ * @return Error code.
+ * @retval EOK Switched to the fiber (or fiber is the running one).
+ * @retval EINVAL Not called from a fiber or fiber belongs to another set.
+ */
+errno_t fiber_switch(fiber_t* fiber) {
+    fiber_sched_t* sched = fiber_get_sched();
+    if ((sched == NULL) || (sched->current == NULL) || (fiber == NULL)
+            || (fiber->sched != sched)) {
+        return EINVAL;
+    }
+    fiber_t* current = sched->current;
+    if (fiber == current) {
+        return EOK;
+    }
+
+    list_add(fiber->link.prev, &current->link);
+    list_remove(&fiber->link);
+    fiber_switch_to(sched, &current->stack_top, fiber);
+    return EOK;
+}
+
+static void fiber_entry_func_wrapper(void) {
+    // Fibers share TLS of the kernel thread (their context was created
+    // without knowing which thread would run them).
+    tls_set_block(thread_get_current()->tls);
+
+    fiber_sched_t* sched = fiber_get_sched();
+    fiber_reap(sched);
+
+    fiber_t* fiber = sched->current;
+    fiber->entry_func(fiber->data);
+
+    sched->fiber_count--;
+    assert(sched->zombie == NULL);
+    sched->zombie = fiber;
+
+    link_t* next = list_pop(&sched->ready);
+    fiber_switch_to(sched, &fiber->stack_top,
+            (next == NULL) ? NULL : list_item(next, fiber_t, link));
+
+    panic("fiber_entry_func_wrapper: finished fiber was resumed");
+}
@@ -2,105 +2,306 @@
 // Copyright 2019 Charles University
 
 #include <debug.h>
+#include <debug/trace.h>
+#include <drivers/cp0.h>
 #include <proc/scheduler.h>
 #include <adt/list.h>
 #include <mm/heap.h>
 
 #include <lib/print.h>
+#include <lib/string.h>
 
-#define INDEX_OF(ITEMPTR, ARRAYPTR) \
-    ((size_t)(((uintptr_t)ITEMPTR - (uintptr_t)ARRAYPTR) / sizeof(*ARRAYPTR)))
+/** Id of the running thread for trace records (0 before the first one runs). */
+static inline unative_t current_thread_id(void) {
+    thread_t* current = thread_get_current();
+    return (current == NULL) ? 0 : current->id;
+}
 
-#define THREAD_POOL_SIZE 100
+/*
+ * The scheduler keeps ready threads in a ready queue. The running thread is
+ * not part of the queue, it is put back when it gives up the processor
+ * while still READY.
+ *
+ * By default the queue is a FIFO list (round-robin). With KERNEL_SCHED_FAIR
+ * it is a binary min-heap ordered by virtual run time, i.e. the thread that
+ * used the least processor time runs next (similar to CFS in Linux). Both
+ * variants provide the same ready_queue_* and fair_* functions below.
+ */
 
-typedef struct queue_item {
-    thread_t* thread;
-    link_t link;
-} queue_item_t;
+#ifdef KERNEL_SCHED_FAIR
 
-static size_t queue_size;
-static queue_item_t* current_item;
-static queue_item_t* schedule_pool;
+/** Min-heap of ready threads, thread->sched_index is position in it. */
+static thread_t** ready_heap;
+static size_t ready_heap_size;
+static size_t ready_heap_capacity;
 
-static list_t ready_thread_queue;
-static list_t suspended_thread_queue;
+/** Threads that can be in the heap (created but not finished yet). */
+static size_t live_thread_count;
 
-static size_t free_indices_stack_top;
-static size_t* free_indices_stack;  // Grows downwards
+/** Lower bound of vruntime of all runnable threads (never decreases). */
+static unative_t min_vruntime;
 
-/** Scheduling stategy.
+/** When the running thread got the processor (or was last accounted). */
+static unative_t slice_start;
+
+/** Compare virtual run times (they are allowed to wrap around). */
+static inline bool vruntime_before(unative_t a, unative_t b) {
+    return (native_t)(a - b) < 0;
+}
+
+static inline void heap_set(size_t index, thread_t* thread) {
+    ready_heap[index] = thread;
+    thread->sched_index = index;
+}
+
+static void heap_sift_up(size_t index) {
+    thread_t* thread = ready_heap[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!vruntime_before(thread->vruntime, ready_heap[parent]->vruntime)) {
+            break;
+        }
+        heap_set(index, ready_heap[parent]);
+        index = parent;
+    }
+    heap_set(index, thread);
+}
+
+static void heap_sift_down(size_t index) {
+    thread_t* thread = ready_heap[index];
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= ready_heap_size) {
+            break;
+        }
+        if ((child + 1 < ready_heap_size)
+                && vruntime_before(ready_heap[child + 1]->vruntime, ready_heap[child]->vruntime)) {
+            child++;
+        }
+        if (!vruntime_before(ready_heap[child]->vruntime, thread->vruntime)) {
+            break;
+        }
+        heap_set(index, ready_heap[child]);
+        index = child;
+    }
+    heap_set(index, thread);
+}
+
+static inline void ready_queue_init(void) {
+    ready_heap = NULL;
+    ready_heap_size = 0;
+    ready_heap_capacity = 0;
+    live_thread_count = 0;
+    min_vruntime = 0;
+    slice_start = 0;
+}
+
+/** Make sure the heap can hold one more thread.
  *
- * Puts item in list as the last one i.e. before current thread.
+ * The heap grows only here (when a thread is created), so inserting into it
+ * later never needs memory.
  */
-static inline void schedule(queue_item_t* item);
+static errno_t ready_queue_reserve(void) {
+    if (live_thread_count == ready_heap_capacity) {
+        size_t capacity = (ready_heap_capacity == 0) ? 16 : 2 * ready_heap_capacity;
+        thread_t** heap = kmalloc(capacity * sizeof(thread_t*));
+        if (heap == NULL) {
+            return ENOMEM;
+        }
+        memcpy(heap, ready_heap, ready_heap_size * sizeof(thread_t*));
+        if (ready_heap != NULL) {
+            kfree(ready_heap);
+        }
+        ready_heap = heap;
+        ready_heap_capacity = capacity;
+    }
+    live_thread_count++;
+    return EOK;
+}
 
-/** Increases the size of preallocated space according to external size of the
- *  thread pool.
- */
-static void resize(void);
+static inline size_t ready_queue_get_size(void) {
+    return ready_heap_size;
+}
 
-static void debug_print_list() {
-    dprintk("\nScheduler state:\n");
-    list_foreach(ready_thread_queue, queue_item_t, link, queue_item) {
-        printk("\titem[%p] %pT\n", &queue_item->link, queue_item->thread);
+static inline void ready_queue_release(void) {
+    assert(live_thread_count > 0);
+    live_thread_count--;
+}
+
+static inline void ready_queue_insert(thread_t* thread) {
+    assert(ready_heap_size < ready_heap_capacity);
+
+    heap_set(ready_heap_size, thread);
+    ready_heap_size++;
+    heap_sift_up(ready_heap_size - 1);
+}
+
+static inline thread_t* ready_queue_pop(void) {
+    if (ready_heap_size == 0) {
+        return NULL;
     }
+
+    thread_t* thread = ready_heap[0];
+    ready_heap_size--;
+    if (ready_heap_size > 0) {
+        heap_set(0, ready_heap[ready_heap_size]);
+        heap_sift_down(0);
+    }
+    return thread;
 }
 
-/** Initialize support for scheduling.
+static inline void ready_queue_remove(thread_t* thread) {
+    size_t index = thread->sched_index;
+    assert(ready_heap[index] == thread);
+
+    ready_heap_size--;
+    if (index != ready_heap_size) {
+        heap_set(index, ready_heap[ready_heap_size]);
+        heap_sift_down(index);
+        heap_sift_up(index);
+    }
+}
+
+/** Remove thread from the queue and insert current instead. */
+static inline void ready_queue_replace(thread_t* thread, thread_t* current) {
+    ready_queue_remove(thread);
+    ready_queue_insert(current);
+}
+
+static void debug_print_queue(void) {
+    dprintk("\nScheduler state (min_vruntime %u):\n", min_vruntime);
+    for (size_t i = 0; i < ready_heap_size; i++) {
+        dprintk("\t[%u] vruntime %u %pT\n", i, ready_heap[i]->vruntime, ready_heap[i]);
+    }
+}
+
+/** Charge processor time used since the last call to the running thread. */
+static inline void fair_account_slice(thread_t* current) {
+    unative_t now = cp0_read_count();
+    if (current != NULL) {
+        current->vruntime += now - slice_start;
+    }
+    slice_start = now;
+}
+
+/** Advance min_vruntime after next was selected to run. */
+static inline void fair_update_min(thread_t* next) {
+    if (vruntime_before(min_vruntime, next->vruntime)) {
+        min_vruntime = next->vruntime;
+    }
+}
+
+/** New threads start with the smallest vruntime of runnable threads. */
+static inline void fair_place_new(thread_t* thread) {
+    thread->vruntime = min_vruntime;
+}
+
+/** Woken thread keeps the processor time it used before sleeping.
  *
- * Called once at system boot.
+ * However, it cannot go further back than SCHEDULER_FAIR_WAKEUP_BONUS before
+ * min_vruntime: sleeping does not earn credit beyond that.
  */
-void scheduler_init(void) {
-    queue_size = THREAD_POOL_SIZE;
-    schedule_pool = (queue_item_t*)
-            kmalloc(sizeof(queue_item_t) * queue_size);
+static inline void fair_place_woken(thread_t* thread) {
+    unative_t floor = min_vruntime - SCHEDULER_FAIR_WAKEUP_BONUS;
+    if (vruntime_before(thread->vruntime, floor)) {
+        thread->vruntime = floor;
+    }
+}
+
+#else
+
+/** Threads that are ready to run (in FIFO order). */
+static counted_list_t ready_thread_queue;
+
+static inline void ready_queue_init(void) {
+    counted_list_init(&ready_thread_queue);
+}
+
+static inline errno_t ready_queue_reserve(void) {
+    return EOK;
+}
+
+static inline void ready_queue_release(void) {
+}
+
+static inline size_t ready_queue_get_size(void) {
+    return counted_list_get_size(&ready_thread_queue);
+}
 
-    free_indices_stack = (size_t*)
-            kmalloc(sizeof(size_t) * queue_size);
+/** Put thread in the queue as the last one, i.e. it will run after all
+ * the threads that are currently ready.
+ */
+static inline void ready_queue_insert(thread_t* thread) {
+    counted_list_append(&ready_thread_queue, &thread->link);
+}
 
-    panic_if(!schedule_pool || !free_indices_stack,
-            "scheduler_init: Not enough memory.");
+static inline thread_t* ready_queue_pop(void) {
+    link_t* link = counted_list_pop(&ready_thread_queue);
+    return (link == NULL) ? NULL : list_item(link, thread_t, link);
+}
 
-    for (size_t i = 0; i < queue_size; ++i) {
-        free_indices_stack[i] = i;
+static inline void ready_queue_remove(thread_t* thread) {
+    counted_list_remove(&ready_thread_queue, &thread->link);
+}
+
+/** Current thread takes over the position of thread in the queue. */
+static inline void ready_queue_replace(thread_t* thread, thread_t* current) {
+    counted_list_add(&ready_thread_queue, thread->link.prev, &current->link);
+    counted_list_remove(&ready_thread_queue, &thread->link);
+}
+
+static void debug_print_queue(void) {
+    dprintk("\nScheduler state:\n");
+    counted_list_foreach(ready_thread_queue, thread_t, link, thread) {
+        dprintk("\tthread[%p] %pT\n", &thread->link, thread);
     }
-    // Stack grows downwards i.e. full stack starts at 0.
-    free_indices_stack_top = 0;
+}
+
+static inline void fair_account_slice(thread_t* current) {
+}
+
+static inline void fair_update_min(thread_t* next) {
+}
 
-    list_init(&ready_thread_queue);
-    list_init(&suspended_thread_queue);
+static inline void fair_place_new(thread_t* thread) {
+}
 
-    // Since no thread is running set this to NULL.
-    current_item = NULL;
+static inline void fair_place_woken(thread_t* thread) {
 }
 
-/** Marks given thread as ready to be executed.
+#endif
+
+/** Initialize support for scheduling.
  *
- * It is expected that this thread would be added at the end
- * of the queue to run in round-robin fashion.
+ * Called once at system boot.
+ */
+void scheduler_init(void) {
+    ready_queue_init();
+}
+
+/** Marks given newly created thread as ready to be executed.
+ *
+ * With round-robin scheduling the thread is added at the end of the queue,
+ * the fair scheduler lets it run after threads that used less processor
+ * time.
  *
  * @param thread Thread to make runnable.
+ * @return Error code.
+ * @retval EOK Thread is ready.
+ * @retval ENOMEM Not enough memory for the ready queue.
  */
-void scheduler_add_ready_thread(thread_t* thread) {
+errno_t scheduler_add_ready_thread(thread_t* thread) {
     dprintk("\n");
 
-    // Check if there is a free space in preallocated array of queue_item_t.
-    if (free_indices_stack_top == queue_size) {
-        resize();
+    errno_t err = ready_queue_reserve();
+    if (err != EOK) {
+        return err;
     }
 
-    queue_item_t* new =
-            &schedule_pool[free_indices_stack[free_indices_stack_top++]];
-
-    new->thread = thread;
-
-    if (current_item == NULL) {
-        dprintk("Thread %s schedules in %pL\n", new->thread->name,
-                &ready_thread_queue);
-        list_append(&ready_thread_queue, &new->link);
-    } else {
-        schedule(new);
-    }
+    thread->state = READY;
+    fair_place_new(thread);
+    ready_queue_insert(thread);
+    return EOK;
 }
 
 /** Removes given thread from scheduling.
@@ -113,22 +314,23 @@ void scheduler_add_ready_thread(thread_t* thread) {
 void scheduler_remove_thread(thread_t* thread) {
     dprintk("\n");
 
-    list_foreach(ready_thread_queue, queue_item_t, link, queue_item) {
-        if (queue_item->thread == thread) {
-            list_remove(&queue_item->link);
-            free_indices_stack[++free_indices_stack_top] =
-                    INDEX_OF(queue_item, schedule_pool);
-            return;
-        }
+    if (thread == thread_get_current()) {
+        scheduler_remove_current_thread();
+        return;
     }
+    ready_queue_remove(thread);
 }
 
-void scheduler_remove_current_thread() {
+/** Removes currently running (and finishing) thread from scheduling.
+ *
+ * The running thread is never part of the ready queue so there is nothing
+ * to unlink, the caller only has to make sure that its state is no longer
+ * READY before calling scheduler_schedule_next().
+ */
+void scheduler_remove_current_thread(void) {
     dprintk("\n");
 
-    list_remove(&current_item->link);
-    free_indices_stack[++free_indices_stack_top] =
-            INDEX_OF(current_item, schedule_pool);
+    ready_queue_release();
 }
 
 /** Suspends given thread in scheduling.
@@ -138,24 +340,29 @@ void scheduler_remove_current_thread() {
  * @param thread Thread to remove from the queue.
  */
 void scheduler_suspend_thread(thread_t* thread) {
-    // TODO:
-    panic();
-}
-
-void scheduler_suspend_current_thread() {
     dprintk("\n");
 
-    // Remove this thread from the list of ready threads.
-    list_remove(&current_item->link);
+    if (thread == thread_get_current()) {
+        scheduler_suspend_current_thread();
+        return;
+    }
+    if (thread->state == READY) {
+        ready_queue_remove(thread);
+        thread->state = SUSPENDED;
+        trace_record(TRACE_SUSPEND, thread, current_thread_id());
+    }
+}
 
-    // Add it to queue of suspended threads.
-    current_item->thread->state = SUSPENDED;
-    list_append(&suspended_thread_queue, &current_item->link);
+/** Suspends currently running thread and switches to the next one. */
+void scheduler_suspend_current_thread(void) {
+    dprintk("\n");
 
+    thread_t* current_thread = thread_get_current();
+    current_thread->state = SUSPENDED;
+    trace_record(TRACE_SUSPEND, current_thread, current_thread->id);
     scheduler_schedule_next();
 }
 
-
 /** Wakes-up existing thread.
  *
  * Note that waking-up a running (or ready) thread has no effect (i.e. the
@@ -170,80 +377,110 @@ void scheduler_suspend_current_thread() {
  * @retval EINVAL Invalid thread.
  * @retval EEXITED Thread already finished its execution.
  */
-errno_t scheduler_wakeup_thread(thread_t *id) {
+errno_t scheduler_wakeup_thread(thread_t* thread) {
     dprintk("\n");
 
-    if (id->state == FINISHED) {
-        return EEXITED;
+    if (thread == NULL) {
+        return EINVAL;
     }
-    list_foreach(suspended_thread_queue, queue_item_t, link, suspend_item) {
-        if (suspend_item->thread == id) {
-            list_remove(&suspend_item->link);
-
-            suspend_item->thread->state = READY;
-            schedule(suspend_item);
-            return EOK;
-        }
+    switch (thread->state) {
+    case FINISHED:
+        return EEXITED;
+    case SUSPENDED:
+        thread->state = READY;
+        // Waiting for the processor starts now (see thread_switch_to).
+        thread->stats_since = cp0_read_count();
+        trace_record(TRACE_WAKEUP, thread, current_thread_id());
+        fair_place_woken(thread);
+        ready_queue_insert(thread);
+        return EOK;
+    default:
+        return EOK;
     }
-    return EINVAL;
 }
 
-/** Switch to next thread in the queue. */
+/** Switch to next thread in the queue.
+ *
+ * The running thread (if it is still ready) is put back to the queue and
+ * the first thread of the queue gets the processor. Switching to itself
+ * (e.g. only ready thread yields) is a no-op.
+ */
 void scheduler_schedule_next(void) {
-    dprintk("Schedule next from %pL\n", &ready_thread_queue);
+    dprintk("Schedule next\n");
 
-    debug_print_list();
+    debug_print_queue();
 
-    if (current_item == NULL) {
-        current_item = list_item(ready_thread_queue.head.next, queue_item_t, link);
-    }
+    printk_poll_flusher();
 
-    link_t* next_link = current_item->link.next;
-    if (!valid_link(ready_thread_queue, next_link)) {
-        next_link = next_link->next;
-        assert(valid_link(ready_thread_queue, next_link));
+    thread_t* current_thread = thread_get_current();
+    fair_account_slice(current_thread);
+    if ((current_thread != NULL) && (current_thread->state == READY)) {
+        ready_queue_insert(current_thread);
     }
 
-    current_item = list_item(next_link, queue_item_t, link);
+    thread_t* next_thread = ready_queue_pop();
+    panic_if(next_thread == NULL, "scheduler: no thread is ready to run");
+    fair_update_min(next_thread);
 
-    dprintk("scheduled item: %p, thread_name: %s\n", &current_item->link, current_item->thread->name);
+    dprintk("scheduled thread: %s\n", next_thread->name);
 
-    assert(current_item->thread->state == READY);
-    thread_switch_to(current_item->thread);
+    assert(next_thread->state == READY);
+    if (next_thread != current_thread) {
+        thread_switch_to(next_thread);
+    }
 }
 
-thread_t* scheduler_get_running_thread() {
-    return (current_item == NULL) ? NULL : current_item->thread;
-}
+/** Switch directly to the given ready thread.
+ *
+ * The running thread takes over the position of the target in the ready
+ * queue, i.e. it donates the rest of its turn to the target. Other ready
+ * threads keep their positions, so none of them waits longer than with
+ * a plain scheduler_schedule_next(). (The fair scheduler simply orders the
+ * running thread by its own vruntime.)
+ *
+ * @param thread Thread to switch to.
+ * @return Error code.
+ * @retval EOK Switched to the thread (or thread is the running one).
+ * @retval EINVAL Invalid thread or thread is not ready.
+ * @retval EEXITED Thread already finished its execution.
+ */
+errno_t scheduler_yield_to(thread_t* thread) {
+    dprintk("%pT\n", thread);
+
+    thread_t* current_thread = thread_get_current();
+    if (thread == NULL) {
+        return EINVAL;
+    }
+    if (thread == current_thread) {
+        return EOK;
+    }
+    if (thread->state == FINISHED) {
+        return EEXITED;
+    }
+    if (thread->state != READY) {
+        return EINVAL;
+    }
 
-static inline void schedule(queue_item_t* item) {
-    dprintk("Scheduling thread %s in %pL\n", item->thread->name,
-            &ready_thread_queue);
+    fair_account_slice(current_thread);
+    if (current_thread->state == READY) {
+        ready_queue_replace(thread, current_thread);
+    } else {
+        ready_queue_remove(thread);
+    }
+    fair_update_min(thread);
 
-    // TODO append before current thread, check for valid_header
-    list_append(&ready_thread_queue, &item->link);
+    thread_switch_to(thread);
+    return EOK;
+}
 
-    dprintk("Thread %s is scheduled in %pL\n", item->thread->name,
-            &ready_thread_queue);
+thread_t* scheduler_get_running_thread(void) {
+    return thread_get_current();
 }
 
-/** Double the size of the thread_queue, free_indices_stack and correct pointers
- *  in link.
- *
- *  This happens when there are no free indices in thread_queue.
- *
- *  First thread_queue size is doubled and values are copied to new array.
- *
- *  Then free_indices_stack is also doubled and half of it is filled with new
- *  free indices i.e. upper half of thread_queue indices.
- *
- *  Finally since all queue_item structures have been reallocated we have to
- *  reinitialize the array and whole first half thread_queue to it.
+/** Get number of threads waiting for the processor.
  *
- *  Furthermore all globals corresponding to mentioned data structures need
- *  correction.
+ * The running thread is not counted. Takes constant time.
  */
-static void resize() {
-    // TODO:
-    panic("resize\n");
+size_t scheduler_get_ready_count(void) {
+    return ready_queue_get_size();
 }
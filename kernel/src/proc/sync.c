@@ -0,0 +1,331 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#include <debug.h>
+#include <drivers/cp0.h>
+#include <lib/string.h>
+#include <proc/sync.h>
+#include <proc/thread.h>
+
+/*
+ * All primitives here rely on the fact that threads are switched only
+ * cooperatively (there are no interrupts yet), so checking a condition
+ * and parking the thread cannot be interleaved with another thread.
+ */
+
+/** Initialize an empty wait queue.
+ *
+ * @param waitq Wait queue to initialize.
+ */
+void waitq_init(waitq_t* waitq) {
+    list_init(&waitq->waiters);
+}
+
+/** Tells whether any thread is parked in the queue.
+ *
+ * @param waitq Wait queue in question.
+ */
+bool waitq_is_empty(waitq_t* waitq) {
+    return list_is_empty(&waitq->waiters);
+}
+
+/** Park current thread in the wait queue until it is woken via the queue.
+ *
+ * The thread is suspended in the scheduler, i.e. it does not consume
+ * any CPU time while waiting. Stray thread_wakeup() calls are tolerated:
+ * the thread goes back to sleep until waitq_wake() is called on its waiter.
+ *
+ * @param waitq Wait queue to park in.
+ * @param waiter Waiter (usually on caller stack), data is left untouched.
+ */
+void waitq_sleep(waitq_t* waitq, waiter_t* waiter) {
+    waiter->thread = thread_get_current();
+    waiter->woken = false;
+    link_init(&waiter->link);
+    list_append(&waitq->waiters, &waiter->link);
+
+    while (!waiter->woken) {
+        thread_suspend();
+    }
+}
+
+/** Remove the longest waiting thread from the queue without waking it.
+ *
+ * This allows the caller to pass data to the waiter (via waiter->data)
+ * before calling waitq_wake().
+ *
+ * @param waitq Wait queue to take the waiter from.
+ * @return Removed waiter or NULL when the queue is empty.
+ */
+waiter_t* waitq_pop(waitq_t* waitq) {
+    link_t* link = list_pop(&waitq->waiters);
+    if (link == NULL) {
+        return NULL;
+    }
+    return list_item(link, waiter_t, link);
+}
+
+/** Make a thread previously removed by waitq_pop() ready again.
+ *
+ * @param waiter Waiter returned by waitq_pop().
+ */
+void waitq_wake(waiter_t* waiter) {
+    waiter->woken = true;
+    errno_t err = thread_wakeup(waiter->thread);
+    panic_if(err != EOK, "waitq_wake: cannot wake-up %s (%s)",
+            waiter->thread->name, errno_as_str(err));
+}
+
+/** Wake-up the longest waiting thread.
+ *
+ * @param waitq Wait queue to wake-up from.
+ * @return Whether any thread was woken.
+ */
+bool waitq_wakeup_one(waitq_t* waitq) {
+    waiter_t* waiter = waitq_pop(waitq);
+    if (waiter == NULL) {
+        return false;
+    }
+    waitq_wake(waiter);
+    return true;
+}
+
+/** Wake-up all threads parked in the queue.
+ *
+ * @param waitq Wait queue to wake-up from.
+ */
+void waitq_wakeup_all(waitq_t* waitq) {
+    while (waitq_wakeup_one(waitq)) {
+    }
+}
+
+#ifdef KERNEL_LOCK_STATS
+
+static void lock_stats_init(lock_stats_t* stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+static void lock_stats_acquired(lock_stats_t* stats, bool contended,
+        bool spinning) {
+    stats->acquired_at = cp0_read_count();
+    stats->acquisitions++;
+    if (contended) {
+        stats->contended++;
+    }
+    if (spinning) {
+        stats->acquired_by_spinning++;
+    }
+}
+
+static void lock_stats_released(lock_stats_t* stats) {
+    unative_t hold = cp0_read_count() - stats->acquired_at;
+    size_t bucket = 0;
+    while (hold > 1) {
+        hold >>= 1;
+        bucket++;
+    }
+    stats->hold_histogram[bucket]++;
+}
+
+#else
+
+#define lock_stats_init(stats) ((void)0)
+#define lock_stats_acquired(stats, contended, spinning) ((void)0)
+#define lock_stats_released(stats) ((void)0)
+
+#endif
+
+/** Initialize an unlocked mutex.
+ *
+ * @param mutex Mutex to initialize.
+ * @return Error code.
+ * @retval EOK Mutex was initialized.
+ */
+errno_t mutex_init(mutex_t* mutex) {
+    mutex->owner = NULL;
+    waitq_init(&mutex->waitq);
+    lock_stats_init(&mutex->stats);
+    return EOK;
+}
+
+/** Destroy a mutex.
+ *
+ * It is a kernel bug to destroy a locked mutex.
+ *
+ * @param mutex Mutex to destroy.
+ */
+void mutex_destroy(mutex_t* mutex) {
+    panic_if(mutex->owner != NULL, "mutex_destroy: mutex is locked by %s",
+            mutex->owner->name);
+}
+
+/** Lock the mutex, parking the current thread when it is already locked.
+ *
+ * While the owner is running on another CPU, it is likely to unlock the
+ * mutex sooner than a suspend/wakeup round trip would take, so we poll it
+ * up to MUTEX_SPIN_LIMIT times first. A preempted or sleeping owner cannot
+ * release the mutex while we spin, so then we go to sleep immediately
+ * (this is always the case on a single CPU).
+ *
+ * @param mutex Mutex to lock.
+ */
+void mutex_lock(mutex_t* mutex) {
+    thread_t* current_thread = thread_get_current();
+    panic_if(mutex->owner == current_thread,
+            "mutex_lock: %s already owns the mutex", current_thread->name);
+
+    if (mutex->owner == NULL) {
+        mutex->owner = current_thread;
+        lock_stats_acquired(&mutex->stats, false, false);
+        return;
+    }
+
+    for (size_t spins = 0; spins < MUTEX_SPIN_LIMIT; spins++) {
+        thread_t* owner = *(thread_t* volatile*)&mutex->owner;
+        if (owner == NULL) {
+            mutex->owner = current_thread;
+            lock_stats_acquired(&mutex->stats, true, true);
+            return;
+        }
+        if (!thread_is_running(owner)) {
+            break;
+        }
+    }
+
+    // Ownership is handed over by mutex_unlock() directly to us.
+    waiter_t waiter;
+    waitq_sleep(&mutex->waitq, &waiter);
+    assert(mutex->owner == current_thread);
+    lock_stats_acquired(&mutex->stats, true, false);
+}
+
+/** Lock the mutex only if it is not locked already.
+ *
+ * @param mutex Mutex to lock.
+ * @return Whether the mutex was locked by this call.
+ */
+bool mutex_trylock(mutex_t* mutex) {
+    if (mutex->owner != NULL) {
+        return false;
+    }
+    mutex->owner = thread_get_current();
+    lock_stats_acquired(&mutex->stats, false, false);
+    return true;
+}
+
+/** Unlock the mutex.
+ *
+ * When there are waiting threads, the mutex is passed to the one that
+ * waits the longest (and stays locked), so waiters cannot be starved by
+ * a thread that keeps re-locking it.
+ *
+ * @param mutex Mutex to unlock, must be owned by the current thread.
+ */
+void mutex_unlock(mutex_t* mutex) {
+    panic_if(mutex->owner != thread_get_current(),
+            "mutex_unlock: mutex not locked by %s", thread_get_current()->name);
+
+    lock_stats_released(&mutex->stats);
+
+    waiter_t* waiter = waitq_pop(&mutex->waitq);
+    if (waiter == NULL) {
+        mutex->owner = NULL;
+        return;
+    }
+    mutex->owner = waiter->thread;
+    waitq_wake(waiter);
+}
+
+/** Print lock-hold histogram and contention counters of the mutex.
+ *
+ * @param mutex Mutex in question.
+ * @param name Name to print in the header.
+ */
+void mutex_print_stats(mutex_t* mutex, const char* name) {
+#ifdef KERNEL_LOCK_STATS
+    lock_stats_t* stats = &mutex->stats;
+    printk("mutex %s: %u acquisitions, %u contended, %u by spinning\n",
+            name, stats->acquisitions, stats->contended,
+            stats->acquired_by_spinning);
+    for (size_t i = 0; i < LOCK_STATS_BUCKETS; i++) {
+        if (stats->hold_histogram[i] == 0) {
+            continue;
+        }
+        printk("  hold < 2^%u cycles: %u\n", i + 1, stats->hold_histogram[i]);
+    }
+#else
+    printk("mutex %s: lock statistics disabled (KERNEL_LOCK_STATS)\n", name);
+#endif
+}
+
+/** Initialize a semaphore.
+ *
+ * @param sem Semaphore to initialize.
+ * @param value Initial value.
+ * @return Error code.
+ * @retval EOK Semaphore was initialized.
+ */
+errno_t sem_init(sem_t* sem, size_t value) {
+    sem->value = value;
+    waitq_init(&sem->waitq);
+    return EOK;
+}
+
+/** Destroy a semaphore.
+ *
+ * It is a kernel bug to destroy a semaphore somebody waits on.
+ *
+ * @param sem Semaphore to destroy.
+ */
+void sem_destroy(sem_t* sem) {
+    panic_if(!waitq_is_empty(&sem->waitq),
+            "sem_destroy: threads are still waiting");
+}
+
+/** Get current value of the semaphore.
+ *
+ * @param sem Semaphore in question.
+ */
+size_t sem_get_value(sem_t* sem) {
+    return sem->value;
+}
+
+/** Decrement the semaphore, parking current thread while it is zero.
+ *
+ * @param sem Semaphore to decrement.
+ */
+void sem_wait(sem_t* sem) {
+    if (sem->value > 0) {
+        sem->value--;
+        return;
+    }
+
+    // sem_post() hands the unit directly to us without incrementing.
+    waiter_t waiter;
+    waitq_sleep(&sem->waitq, &waiter);
+}
+
+/** Decrement the semaphore only if that does not require waiting.
+ *
+ * @param sem Semaphore to decrement.
+ * @return Error code.
+ * @retval EOK Semaphore was decremented.
+ * @retval EBUSY Semaphore value is zero.
+ */
+errno_t sem_trywait(sem_t* sem) {
+    if (sem->value == 0) {
+        return EBUSY;
+    }
+    sem->value--;
+    return EOK;
+}
+
+/** Increment the semaphore, waking-up one waiting thread if any.
+ *
+ * @param sem Semaphore to increment.
+ */
+void sem_post(sem_t* sem) {
+    if (!waitq_wakeup_one(&sem->waitq)) {
+        sem->value++;
+    }
+}
@@ -2,23 +2,150 @@
 // Copyright 2019 Charles University
 
 #include <lib/print.h>
+#include <lib/string.h>
 #include <proc/context.h>
 #include <proc/scheduler.h>
 #include <proc/thread.h>
 #include <adt/list.h>
 #include <mm/heap.h>
 #include <debug/code.h>
+#include <debug/trace.h>
+#include <drivers/cp0.h>
 
 /** Wraps the thread_entry_function so that it always calls finish.
  */
 static void thread_entry_func_wrapper(void);
 
+/** Thread currently owning the CPU (NULL before the first switch). */
+static thread_t* running_thread;
+
+/** Stack sizes indexed by the THREAD_FLAG_STACK_* value. */
+static const size_t thread_stack_sizes[] = {
+    [THREAD_FLAG_STACK_DEFAULT] = THREAD_STACK_SIZE,
+    [THREAD_FLAG_STACK_TINY] = THREAD_STACK_SIZE_TINY,
+    [THREAD_FLAG_STACK_SMALL] = THREAD_STACK_SIZE_SMALL,
+    [THREAD_FLAG_STACK_LARGE] = THREAD_STACK_SIZE_LARGE,
+};
+
+#define THREAD_STACK_CLASS_COUNT \
+    (sizeof(thread_stack_sizes) / sizeof(thread_stack_sizes[0]))
+
+/** Id of the last created thread. */
+static unative_t last_thread_id;
+
+/** Joined threads whose memory (thread_t and stack) can be reused.
+ *
+ * Kept separately for each stack size.
+ */
+static counted_list_t thread_cache[THREAD_STACK_CLASS_COUNT];
+
+/** Find the stack size class (index into thread_stack_sizes) of a thread. */
+static size_t thread_get_stack_class(thread_t* thread) {
+    for (size_t i = 0; i < THREAD_STACK_CLASS_COUNT; i++) {
+        if (thread_stack_sizes[i] == thread->stack_size) {
+            return i;
+        }
+    }
+    panic("thread %pT has unexpected stack size %u", thread, thread->stack_size);
+}
+
+/** Get memory for thread_t and stack, preferably from the cache.
+ *
+ * @param stack_class Stack size class (index into thread_stack_sizes).
+ * @return Uninitialized thread (except stack_size) or NULL when out of memory.
+ */
+static thread_t* thread_alloc(size_t stack_class) {
+    link_t* link = counted_list_pop(&thread_cache[stack_class]);
+    if (link != NULL) {
+        return list_item(link, thread_t, link);
+    }
+
+    size_t stack_size = thread_stack_sizes[stack_class];
+    thread_t* thread = (thread_t*)kmalloc(sizeof(thread_t) + stack_size);
+    if (thread != NULL) {
+        thread->stack_size = stack_size;
+    }
+    return thread;
+}
+
+/** Release memory of a finished thread nobody refers to any more.
+ *
+ * Up to THREAD_CACHE_SIZE threads of each stack size are kept for reuse,
+ * the rest is freed.
+ *
+ * @param thread Finished and joined thread.
+ */
+static void thread_release(thread_t* thread) {
+    assert(thread->state == FINISHED);
+
+    size_t stack_class = thread_get_stack_class(thread);
+    if (counted_list_get_size(&thread_cache[stack_class]) < THREAD_CACHE_SIZE) {
+        counted_list_append(&thread_cache[stack_class], &thread->link);
+    } else {
+        kfree(thread);
+    }
+}
+
+/** Fill the whole stack below the initial context with the paint pattern
+ * and place the canary at its bottom.
+ *
+ * @param thread Thread with initial context already set up.
+ */
+static void thread_paint_stack(thread_t* thread) {
+    unative_t* bottom = THREAD_STACK_BOTTOM(thread);
+    unative_t* context = (unative_t*)THREAD_INITIAL_CONTEXT(thread);
+
+    bottom[0] = THREAD_STACK_CANARY;
+    for (unative_t* it = bottom + 1; it < context; it++) {
+        *it = THREAD_STACK_PAINT;
+    }
+}
+
+/** Halt the kernel when the thread has overwritten its stack canary.
+ *
+ * Part of thread_t (and possibly other memory) is probably already damaged
+ * at this point, so there is no point in trying to continue.
+ *
+ * @param thread Thread to check.
+ */
+static inline void thread_check_stack(thread_t* thread) {
+    panic_if(THREAD_STACK_BOTTOM(thread)[0] != THREAD_STACK_CANARY,
+            "stack overflow in thread %pT (stack size %u)",
+            thread, thread->stack_size);
+}
+
+/** Account end of the running time slice of a thread. */
+static inline void thread_account_switch_out(thread_t* thread, unative_t now) {
+    thread->stats.run_cycles += now - thread->stats_since;
+    thread->stats_since = now;
+    if (thread->state == READY) {
+        thread->stats.involuntary_switches++;
+    } else {
+        thread->stats.voluntary_switches++;
+    }
+}
+
+/** Account end of waiting of a ready thread for the processor.
+ *
+ * stats_since is the time of the switch out (if the thread remained ready)
+ * or of the wake-up (set by the scheduler).
+ */
+static inline void thread_account_switch_in(thread_t* thread, unative_t now) {
+    thread->stats.wait_cycles += now - thread->stats_since;
+    thread->stats_since = now;
+    thread->stats.switches++;
+}
+
 /** Initialize support for threading.
  *
  * Called once at system boot.
  */
 void threads_init(void) {
-
+    running_thread = NULL;
+    last_thread_id = 0;
+    for (size_t i = 0; i < THREAD_STACK_CLASS_COUNT; i++) {
+        counted_list_init(&thread_cache[i]);
+    }
 }
 
 /** Create a new thread.
@@ -26,50 +153,75 @@ void threads_init(void) {
  * The thread is automatically placed into the queue of ready threads.
  *
  * This function allocates space for both stack and the thread_t structure
- * (hence the double <code>**</code> in <code>thread_out</code>.
+ * (hence the double <code>**</code> in <code>thread_out</code>. Memory of
+ * recently joined threads is reused when available.
  *
- * WARNIGN: Caller is responsible for freeing this pointer after the thread
- *          finishes and caller has dealt with return value if need be.
+ * The returned thread_t is valid until the thread is joined, thread_join
+ * releases it.
+ *
+ * The stack size is selected by one of THREAD_FLAG_STACK_* flags, e.g.
+ * THREAD_FLAG_STACK_TINY for simple workers or THREAD_FLAG_STACK_LARGE for
+ * deep recursion (no flag gives THREAD_STACK_SIZE).
  *
  * @param thread_out Where to place the initialized thread_t structure.
  * @param entry Thread entry function.
  * @param data Data for the entry function.
- * @param flags Flags (unused).
+ * @param flags Flags (THREAD_FLAG_*).
  * @param name Thread name (for debugging purposes).
  * @return Error code.
  * @retval EOK Thread was created and started (added to ready queue).
  * @retval ENOMEM Not enough memory to complete the operation.
- * @retval INVAL Invalid flags (unused).
+ * @retval EINVAL Invalid flags.
  */
 errno_t thread_create(thread_t** thread_out, thread_entry_func_t entry, void* data, unsigned int flags, const char* name) {
     dprintk("\n");
 
+    if ((flags & ~THREAD_FLAG_STACK_MASK) != 0) {
+        return EINVAL;
+    }
+
     // Allocate enought memory for stack and thread_t structure.
-    // No heap is available.
-    thread_t* thread = (thread_t*)kmalloc(sizeof(thread_t) + THREAD_STACK_SIZE);
+    thread_t* thread = thread_alloc(flags & THREAD_FLAG_STACK_MASK);
     if (thread == NULL) {
         return ENOMEM;
     }
 
-
     // Set up thread_t structure.
+    thread->id = ++last_thread_id;
     strncpy((char*)thread->name, name, THREAD_NAME_MAX_LENGTH);
+    thread->name[THREAD_NAME_MAX_LENGTH] = '\0';
     thread->entry_func = entry;
     thread->data = data;
-    thread->state = READY;
+    thread->retval = NULL;
+    memset(&thread->stats, 0, sizeof(thread->stats));
+    thread->stats_since = cp0_read_count();
+    thread->joiner = NULL;
+    thread->fiber_sched = NULL;
+    link_init(&thread->link);
+    memset(thread->tls, 0, THREAD_TLS_SIZE);
 
     // Set up stack
     context_t* context = THREAD_INITIAL_CONTEXT(thread);
     context->sp = THREAD_INITIAL_STACK_TOP(thread);
     context->ra = (unative_t)&thread_entry_func_wrapper;
+    context->gp = (unative_t)thread->tls;
     context->status = 0xff01;
 
+    thread_paint_stack(thread);
+
     thread->stack_top = (unative_t)context;
 
     dprintk("New thread allocated: %pT\n", thread);
+    trace_thread_created(thread);
+
+    errno_t err = scheduler_add_ready_thread(thread);
+    if (err != EOK) {
+        thread->state = FINISHED;
+        thread_release(thread);
+        return err;
+    }
 
     *thread_out = thread;
-    scheduler_add_ready_thread(*thread_out);
     return EOK;
 }
 
@@ -78,17 +230,33 @@ errno_t thread_create(thread_t** thread_out, thread_entry_func_t entry, void* da
  * @retval NULL When no thread was started yet.
  */
 thread_t* thread_get_current(void) {
-
-    return scheduler_get_running_thread();
+    return running_thread;
 }
 
 /** Yield the processor. */
 void thread_yield(void) {
     dprintk("\n");
-    thread_get_current()->stack_top = debug_get_stack_pointer();
+
     scheduler_schedule_next();
 }
 
+/** Yield the processor directly to the given thread.
+ *
+ * Unlike thread_yield(), the target runs next no matter how many threads
+ * are ready, which is useful e.g. right after waking-up a consumer.
+ *
+ * @param thread Ready thread to run next.
+ * @return Error code.
+ * @retval EOK Processor was yielded (and we run again).
+ * @retval EINVAL Invalid thread or thread is not ready.
+ * @retval EEXITED Thread already finished its execution.
+ */
+errno_t thread_yield_to(thread_t* thread) {
+    dprintk("\n");
+
+    return scheduler_yield_to(thread);
+}
+
 /** Current thread stops execution and is not scheduled until woken up. */
 void thread_suspend(void) {
     dprintk("\n");
@@ -112,12 +280,16 @@ void thread_finish(void* retval) {
     thread_t* current_thread = thread_get_current();
     current_thread->state = FINISHED;
     current_thread->retval = retval;
+    trace_record(TRACE_FINISH, current_thread, 0);
+
+    if (current_thread->joiner != NULL) {
+        thread_wakeup(current_thread->joiner);
+    }
 
     scheduler_remove_current_thread();
     scheduler_schedule_next();
 
-    // Noreturn functionw
-    while (1);
+    panic("thread_finish: finished thread was scheduled again");
 }
 
 
@@ -129,7 +301,18 @@ void thread_finish(void* retval) {
 bool thread_has_finished(thread_t* thread) {
     dprintk("\n");
 
-    return false;
+    return thread->state == FINISHED;
+}
+
+/** Tells if thread is executing on a CPU right now.
+ *
+ * With a single CPU only the current thread is running, hence any other
+ * thread checked by the current one is never running.
+ *
+ * @param thread Thread in question.
+ */
+bool thread_is_running(thread_t* thread) {
+    return thread == running_thread;
 }
 
 /** Wakes-up existing thread.
@@ -157,6 +340,10 @@ errno_t thread_wakeup(thread_t* thread) {
  * Note that <code>retval</code> could be <code>NULL</code> if the caller
  * is not interested in the returned value.
  *
+ * The joining thread is suspended until the other thread finishes. Once
+ * joined, the thread is released (its memory may be reused by another
+ * thread) and must not be used any more.
+ *
  * @param thread Thread to wait for.
  * @param retval Where to place the value returned from thread_finish.
  * @return Error code.
@@ -167,13 +354,79 @@ errno_t thread_wakeup(thread_t* thread) {
 errno_t thread_join(thread_t* thread, void** retval) {
     dprintk("\n");
 
-    if (thread == NULL) {
+    if ((thread == NULL) || (thread == thread_get_current())) {
         return EINVAL;
     }
+    if (thread->joiner != NULL) {
+        return EBUSY;
+    }
+
+    thread->joiner = thread_get_current();
+    // Stray wake-ups from other threads are possible, hence the loop.
     while (thread->state != FINISHED) {
-        thread_yield();
+        thread_suspend();
+    }
+
+    if (retval != NULL) {
+        *retval = thread->retval;
+    }
+    thread_release(thread);
+    return EOK;
+}
+
+/** Get maximum stack usage of a thread so far.
+ *
+ * The stack is painted with a known pattern when the thread is created,
+ * the usage is the distance from the stack top to the deepest overwritten
+ * word. It can be called on a finished thread (until it is joined) to find
+ * out how much stack the thread needed during its whole life.
+ *
+ * Note that the value is a lower bound: a function may reserve stack space
+ * without writing it (or write the paint pattern itself).
+ *
+ * @param thread Thread in question.
+ * @return Number of bytes of stack used (stack size on overflow).
+ */
+size_t thread_get_stack_usage(thread_t* thread) {
+    assert(thread != NULL);
+
+    unative_t* bottom = THREAD_STACK_BOTTOM(thread);
+    if (bottom[0] != THREAD_STACK_CANARY) {
+        return thread->stack_size;
+    }
+
+    unative_t* top = (unative_t*)THREAD_INITIAL_STACK_TOP(thread);
+    unative_t* it = bottom + 1;
+    while ((it < top) && (*it == THREAD_STACK_PAINT)) {
+        it++;
+    }
+    return (uintptr_t)top - (uintptr_t)it;
+}
+
+/** Get CPU accounting of a thread.
+ *
+ * The values include the current time slice of a running thread and the
+ * current wait of a ready one. Finished threads can be queried until they
+ * are joined.
+ *
+ * @param thread Thread in question.
+ * @param stats Where to store the statistics.
+ * @return Error code.
+ * @retval EOK Statistics were stored.
+ * @retval EINVAL Invalid thread.
+ */
+errno_t thread_get_stats(thread_t* thread, thread_stats_t* stats) {
+    if (thread == NULL) {
+        return EINVAL;
+    }
+
+    *stats = thread->stats;
+    unative_t pending = cp0_read_count() - thread->stats_since;
+    if (thread == running_thread) {
+        stats->run_cycles += pending;
+    } else if (thread->state == READY) {
+        stats->wait_cycles += pending;
     }
-    *retval = thread->retval;
     return EOK;
 }
 
@@ -187,13 +440,25 @@ errno_t thread_join(thread_t* thread, void** retval) {
 void thread_switch_to(thread_t* thread) {
     dprintk("%pT\n", thread);
 
-    thread_t* current_thread = thread_get_current();
+    // The very first switch comes from the boot stack that is never resumed,
+    // its stack top is stored into a dummy variable.
+    unative_t boot_stack_top;
+    unative_t* stack_top_old = &boot_stack_top;
+    unative_t now = cp0_read_count();
+    if (running_thread != NULL) {
+        thread_check_stack(running_thread);
+        thread_account_switch_out(running_thread, now);
+        trace_record(TRACE_SWITCH_OUT, running_thread, running_thread->state);
+        stack_top_old = &running_thread->stack_top;
+    }
+    thread_account_switch_in(thread, now);
+    trace_record(TRACE_SWITCH_IN, thread, (running_thread == NULL) ? 0 : running_thread->id);
 
-    void* stack_top_old = current_thread ? (void*)current_thread->stack_top :
-            (void*)debug_get_stack_pointer();
-    void* stack_top_new = (void*)thread->stack_top;
+    running_thread = thread;
 
-    cpu_switch_context(&stack_top_old, &stack_top_new, 1);
+    // We get here only by a function call (there is no preemption), so
+    // saving the callee-saved registers is enough.
+    cpu_switch_context_fast((void**)stack_top_old, (void**)&thread->stack_top, 1);
 }
 
 static void thread_entry_func_wrapper() {
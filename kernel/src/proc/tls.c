@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#include <proc/thread.h>
+#include <proc/tls.h>
+
+/** Bytes of the TLS block already reserved. */
+static size_t tls_used = 0;
+
+/** Reserve an area in the TLS block of every thread.
+ *
+ * Reservations cannot be released, they are expected to be made once
+ * during initialization of a subsystem. The area is word-aligned and
+ * zeroed when a thread is created (the whole block is zeroed, so threads
+ * created before the reservation see zeros too).
+ *
+ * @param size Size of the area in bytes.
+ * @param offset_out Where to store the offset for tls_get.
+ * @return Error code.
+ * @retval EOK Area was reserved.
+ * @retval ENOMEM Not enough space left in THREAD_TLS_SIZE.
+ */
+errno_t tls_reserve(size_t size, size_t* offset_out) {
+    size_t aligned_size = (size + sizeof(unative_t) - 1) & ~(sizeof(unative_t) - 1);
+    if (aligned_size > THREAD_TLS_SIZE - tls_used) {
+        return ENOMEM;
+    }
+
+    *offset_out = tls_used;
+    tls_used += aligned_size;
+    return EOK;
+}
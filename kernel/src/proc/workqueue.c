@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#include <debug.h>
+#include <mm/heap.h>
+#include <proc/workqueue.h>
+
+/*
+ * Woken threads always re-check their condition: between the wake-up and
+ * the moment the woken thread runs, other threads may have taken the work
+ * (or the free slot) it was woken for.
+ */
+
+static inline void queue_put(workqueue_t* wq, work_func_t func, void* arg) {
+    assert(wq->count < wq->capacity);
+
+    size_t tail = wq->head + wq->count;
+    if (tail >= wq->capacity) {
+        tail -= wq->capacity;
+    }
+    wq->queue[tail].func = func;
+    wq->queue[tail].arg = arg;
+    wq->count++;
+    wq->pending++;
+}
+
+static inline work_t queue_take(workqueue_t* wq) {
+    assert(wq->count > 0);
+
+    work_t work = wq->queue[wq->head];
+    wq->head++;
+    if (wq->head == wq->capacity) {
+        wq->head = 0;
+    }
+    wq->count--;
+    return work;
+}
+
+static void* worker_loop(void* arg) {
+    workqueue_t* wq = arg;
+
+    while (true) {
+        while ((wq->count == 0) && !wq->terminating) {
+            waiter_t waiter;
+            waitq_sleep(&wq->idle_workers, &waiter);
+        }
+        if (wq->count == 0) {
+            break;
+        }
+
+        work_t work = queue_take(wq);
+        waitq_wakeup_one(&wq->submitters);
+
+        work.func(work.arg);
+
+        wq->pending--;
+        if (wq->pending == 0) {
+            waitq_wakeup_all(&wq->completion_waiters);
+        }
+    }
+
+    return NULL;
+}
+
+/** Stop and join the first count workers (the queue must be empty). */
+static void workqueue_stop_workers(workqueue_t* wq, size_t count) {
+    wq->terminating = true;
+    waitq_wakeup_all(&wq->idle_workers);
+    for (size_t i = 0; i < count; i++) {
+        errno_t err = thread_join(wq->workers[i], NULL);
+        panic_if(err != EOK, "workqueue: cannot join worker (%s)", errno_as_str(err));
+    }
+}
+
+/** Create a work queue and start its worker threads.
+ *
+ * @param wq_out Where to store pointer to the new work queue.
+ * @param worker_count Number of worker threads (at least one).
+ * @param capacity Number of work items that can be queued (at least one).
+ * @param thread_flags Flags for thread_create of workers (e.g. stack size).
+ * @return Error code.
+ * @retval EOK Work queue was created.
+ * @retval EINVAL Invalid worker count, capacity or thread flags.
+ * @retval ENOMEM Not enough memory to complete the operation.
+ */
+errno_t workqueue_create(workqueue_t** wq_out, size_t worker_count, size_t capacity, unsigned int thread_flags) {
+    if ((worker_count == 0) || (capacity == 0)) {
+        return EINVAL;
+    }
+
+    workqueue_t* wq = kmalloc(sizeof(workqueue_t)
+            + worker_count * sizeof(thread_t*) + capacity * sizeof(work_t));
+    if (wq == NULL) {
+        return ENOMEM;
+    }
+
+    wq->worker_count = worker_count;
+    wq->workers = (thread_t**)(wq + 1);
+    wq->capacity = capacity;
+    wq->count = 0;
+    wq->head = 0;
+    wq->queue = (work_t*)(wq->workers + worker_count);
+    wq->pending = 0;
+    wq->terminating = false;
+    waitq_init(&wq->idle_workers);
+    waitq_init(&wq->submitters);
+    waitq_init(&wq->completion_waiters);
+
+    for (size_t i = 0; i < worker_count; i++) {
+        errno_t err = thread_create(&wq->workers[i], worker_loop, wq, thread_flags, "worker");
+        if (err != EOK) {
+            workqueue_stop_workers(wq, i);
+            kfree(wq);
+            return err;
+        }
+    }
+
+    *wq_out = wq;
+    return EOK;
+}
+
+/** Finish all submitted work, stop the workers and free the work queue.
+ *
+ * It is a kernel bug to submit work to a queue being destroyed.
+ *
+ * @param wq Work queue to destroy.
+ */
+void workqueue_destroy(workqueue_t* wq) {
+    work_wait(wq);
+    workqueue_stop_workers(wq, wq->worker_count);
+
+    panic_if(!waitq_is_empty(&wq->submitters) || !waitq_is_empty(&wq->completion_waiters),
+            "workqueue_destroy: threads are still waiting");
+    kfree(wq);
+}
+
+/** Submit work, waiting while the queue is full.
+ *
+ * The function is executed by one of the workers. Work may be submitted
+ * from inside another work function, but that blocks the worker if the
+ * queue is full.
+ *
+ * @param wq Work queue to submit to.
+ * @param func Function to execute.
+ * @param arg Argument for the function.
+ */
+void work_submit(workqueue_t* wq, work_func_t func, void* arg) {
+    while (wq->count == wq->capacity) {
+        waiter_t waiter;
+        waitq_sleep(&wq->submitters, &waiter);
+    }
+
+    queue_put(wq, func, arg);
+    waitq_wakeup_one(&wq->idle_workers);
+}
+
+/** Submit work only if that does not require waiting.
+ *
+ * @param wq Work queue to submit to.
+ * @param func Function to execute.
+ * @param arg Argument for the function.
+ * @return Error code.
+ * @retval EOK Work was submitted.
+ * @retval EBUSY Queue is full.
+ */
+errno_t work_try_submit(workqueue_t* wq, work_func_t func, void* arg) {
+    if (wq->count == wq->capacity) {
+        return EBUSY;
+    }
+
+    queue_put(wq, func, arg);
+    waitq_wakeup_one(&wq->idle_workers);
+    return EOK;
+}
+
+/** Wait until all work submitted so far (and since) has finished.
+ *
+ * Must not be called from a work function (it would wait for itself).
+ *
+ * @param wq Work queue to wait on.
+ */
+void work_wait(workqueue_t* wq) {
+    while (wq->pending > 0) {
+        waiter_t waiter;
+        waitq_sleep(&wq->completion_waiters, &waiter);
+    }
+}
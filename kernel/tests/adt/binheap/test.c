@@ -0,0 +1,115 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Test of the binary heap: pseudo-random keys must come out sorted,
+ * arbitrary items can be removed and re-keyed. Finally, insert and pop
+ * are timed for a heap of a few hundred items.
+ */
+
+#include <adt/binheap.h>
+#include <drivers/cp0.h>
+#include <ktest.h>
+
+#define ITEMS 400
+
+typedef struct {
+    uint32_t key;
+    binheap_node_t node;
+} item_t;
+
+static item_t items[ITEMS];
+static binheap_node_t* slots[ITEMS];
+
+static bool item_less(const binheap_node_t* a, const binheap_node_t* b) {
+    return binheap_item(a, item_t, node)->key < binheap_item(b, item_t, node)->key;
+}
+
+static uint32_t random_state = 4242;
+
+static uint32_t next_random(void) {
+    random_state = random_state * 1103515245 + 12345;
+    return random_state >> 8;
+}
+
+static void check_heap(binheap_t* heap) {
+    for (size_t i = 0; i < heap->size; i++) {
+        ktest_assert(heap->slots[i]->index == i, "node at %u thinks it is at %u",
+                i, heap->slots[i]->index);
+        if (i > 0) {
+            ktest_assert(!item_less(heap->slots[i], heap->slots[(i - 1) / 2]),
+                    "node %u smaller than its parent", i);
+        }
+    }
+}
+
+/** Pop everything, keys must not decrease. */
+static void drain_sorted(binheap_t* heap, size_t expected_count) {
+    uint32_t previous = 0;
+    size_t count = 0;
+    binheap_node_t* node;
+    while ((node = binheap_pop(heap)) != NULL) {
+        uint32_t key = binheap_item(node, item_t, node)->key;
+        ktest_assert(key >= previous, "%u popped after %u", key, previous);
+        previous = key;
+        count++;
+    }
+    ktest_assert(count == expected_count, "popped %u instead of %u", count, expected_count);
+    ktest_assert(binheap_is_empty(heap), "heap not empty");
+}
+
+void kernel_test(void) {
+    ktest_start("adt/binheap");
+
+    binheap_t heap;
+    binheap_init(&heap, slots, ITEMS, item_less);
+    ktest_assert(binheap_peek(&heap) == NULL, "peek on empty heap");
+    ktest_assert(binheap_pop(&heap) == NULL, "pop on empty heap");
+
+    for (int i = 0; i < ITEMS; i++) {
+        items[i].key = next_random() % 1000;
+        ktest_assert(binheap_insert(&heap, &items[i].node), "insert %d failed", i);
+    }
+    check_heap(&heap);
+    item_t extra = { .key = 0 };
+    ktest_assert(!binheap_insert(&heap, &extra.node), "insert into full heap");
+    drain_sorted(&heap, ITEMS);
+
+    // Remove every third item and re-key every fifth one.
+    for (int i = 0; i < ITEMS; i++) {
+        binheap_insert(&heap, &items[i].node);
+    }
+    size_t count = ITEMS;
+    for (int i = 0; i < ITEMS; i += 3) {
+        binheap_remove(&heap, &items[i].node);
+        count--;
+    }
+    check_heap(&heap);
+    for (int i = 1; i < ITEMS; i += 15) {
+        items[i].key = (i % 2 == 0) ? 0 : 5000;
+        binheap_update(&heap, &items[i].node);
+    }
+    check_heap(&heap);
+    ktest_assert(binheap_get_size(&heap) == count, "size %u", binheap_get_size(&heap));
+    drain_sorted(&heap, count);
+
+    // Timing of a full cycle of inserts and pops.
+    for (int i = 0; i < ITEMS; i++) {
+        items[i].key = next_random();
+    }
+    unative_t start = cp0_read_count();
+    for (int i = 0; i < ITEMS; i++) {
+        binheap_insert(&heap, &items[i].node);
+    }
+    unative_t insert_cycles = (cp0_read_count() - start) / ITEMS;
+
+    start = cp0_read_count();
+    while (binheap_pop(&heap) != NULL) {
+    }
+    unative_t pop_cycles = (cp0_read_count() - start) / ITEMS;
+
+    printk("heap of %d items: %u cycles per insert, %u cycles per pop\n",
+            ITEMS, insert_cycles, pop_cycles);
+
+    ktest_passed();
+}
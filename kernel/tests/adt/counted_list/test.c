@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Checks that counted_list_t keeps its size in sync with the actual number
+ * of items through all the operations that add or remove them.
+ */
+
+#include <adt/list.h>
+#include <ktest.h>
+
+#define ITEM_COUNT 8
+
+typedef struct {
+    int value;
+    link_t link;
+} item_t;
+
+static void check_size(counted_list_t* list, size_t expected) {
+    size_t size = counted_list_get_size(list);
+    ktest_assert(size == expected, "size is %u, expected %u", size, expected);
+    size_t walked = list_get_size(&list->list);
+    ktest_assert(walked == expected, "list has %u items, expected %u", walked, expected);
+    ktest_assert(counted_list_is_empty(list) == (expected == 0),
+            "emptiness does not match size %u", expected);
+}
+
+void kernel_test(void) {
+    ktest_start("adt/counted_list");
+
+    item_t items[ITEM_COUNT];
+    for (int i = 0; i < ITEM_COUNT; i++) {
+        items[i].value = i;
+        link_init(&items[i].link);
+    }
+
+    counted_list_t list;
+    counted_list_init(&list);
+    check_size(&list, 0);
+    ktest_assert(counted_list_pop(&list) == NULL, "pop from an empty list");
+    check_size(&list, 0);
+
+    // 1 2 3 0
+    for (int i = 1; i < 4; i++) {
+        counted_list_append(&list, &items[i].link);
+    }
+    counted_list_append(&list, &items[0].link);
+    check_size(&list, 4);
+
+    // 4 1 2 3 0
+    counted_list_prepend(&list, &items[4].link);
+    check_size(&list, 5);
+
+    // 4 1 5 2 3 0
+    counted_list_add(&list, &items[1].link, &items[5].link);
+    check_size(&list, 6);
+
+    // 4 5 2 0
+    counted_list_remove(&list, &items[1].link);
+    counted_list_remove(&list, &items[3].link);
+    check_size(&list, 4);
+
+    // 5 2 0 4
+    link_t* rotated = counted_list_rotate(&list);
+    ktest_assert(rotated == &items[4].link, "rotated wrong item");
+    check_size(&list, 4);
+
+    int expected[] = { 5, 2, 0, 4 };
+    int index = 0;
+    counted_list_foreach(list, item_t, link, item) {
+        ktest_assert(item->value == expected[index], "item %d is %d, expected %d",
+                index, item->value, expected[index]);
+        index++;
+    }
+    ktest_assert(index == 4, "iterated over %d items", index);
+
+    for (size_t remaining = 4; remaining > 0; remaining--) {
+        link_t* link = counted_list_pop(&list);
+        ktest_assert(link != NULL, "pop returned NULL with %u items", remaining);
+        check_size(&list, remaining - 1);
+    }
+
+    ktest_passed();
+}
@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Test of the hash table keyed by pointers: every inserted item must be
+ * found (and only those), removal and resize must keep the rest reachable.
+ * Finally, lookups in a table with a few thousand items are timed against
+ * a linear scan of a list.
+ */
+
+#include <adt/hash_table.h>
+#include <drivers/cp0.h>
+#include <ktest.h>
+
+#define ITEMS 4096
+#define SMALL_BUCKETS 64
+#define BUCKETS 2048
+#define SCAN_LOOKUPS 256
+
+typedef struct {
+    /** The key, address of the corresponding owner. */
+    const void* owner;
+    link_t hash_link;
+    link_t list_link;
+} item_t;
+
+static item_t items[ITEMS];
+static uint32_t owners[ITEMS];
+
+static list_t small_buckets[SMALL_BUCKETS];
+static list_t buckets[BUCKETS];
+
+static uint32_t item_hash(const link_t* link) {
+    return hash_pointer(list_item(link, item_t, hash_link)->owner);
+}
+
+static uint32_t key_hash(const void* key) {
+    return hash_pointer(key);
+}
+
+static bool key_equal(const void* key, const link_t* link) {
+    return list_item(link, item_t, hash_link)->owner == key;
+}
+
+static const hash_table_ops_t ops = { item_hash, key_hash, key_equal };
+
+static item_t* find(hash_table_t* table, const void* key) {
+    link_t* link = hash_table_find(table, key);
+    return (link == NULL) ? NULL : list_item(link, item_t, hash_link);
+}
+
+/** Check that exactly the items in [present_from, present_to) are found. */
+static void check_lookups(hash_table_t* table, int present_from, int present_to) {
+    for (int i = 0; i < ITEMS; i++) {
+        item_t* found = find(table, &owners[i]);
+        if ((i >= present_from) && (i < present_to)) {
+            ktest_assert(found == &items[i], "item %d not found (got %p)", i, found);
+        } else {
+            ktest_assert(found == NULL, "removed item %d found", i);
+        }
+    }
+    size_t expected = present_to - present_from;
+    ktest_assert(hash_table_get_size(table) == expected, "size is %u, expected %u",
+            hash_table_get_size(table), expected);
+}
+
+static void check_correctness(void) {
+    hash_table_t table;
+    hash_table_init(&table, small_buckets, SMALL_BUCKETS, &ops);
+    ktest_assert(hash_table_is_empty(&table), "new table not empty");
+    ktest_assert(find(&table, &owners[0]) == NULL, "found in an empty table");
+
+    for (int i = 0; i < ITEMS; i++) {
+        hash_table_insert(&table, &items[i].hash_link);
+    }
+    ktest_assert(hash_table_needs_resize(&table), "%u items in %u buckets need resize",
+            ITEMS, SMALL_BUCKETS);
+    check_lookups(&table, 0, ITEMS);
+
+    size_t counted = 0;
+    hash_table_foreach(&table, item_t, hash_link, item) {
+        ktest_assert((item >= items) && (item < items + ITEMS), "foreach gave %p", item);
+        counted++;
+    }
+    ktest_assert(counted == ITEMS, "foreach visited %u items", counted);
+
+    list_t* old = hash_table_resize(&table, buckets, BUCKETS);
+    ktest_assert(old == small_buckets, "resize returned %p", old);
+    ktest_assert(!hash_table_needs_resize(&table), "resized table still too full");
+    check_lookups(&table, 0, ITEMS);
+
+    // Remove the first half, alternately by key and by link.
+    for (int i = 0; i < ITEMS / 2; i++) {
+        if (i % 2 == 0) {
+            link_t* removed = hash_table_remove_key(&table, &owners[i]);
+            ktest_assert(removed == &items[i].hash_link, "removed %p instead of item %d",
+                    removed, i);
+        } else {
+            hash_table_remove(&table, &items[i].hash_link);
+        }
+    }
+    ktest_assert(hash_table_remove_key(&table, &owners[0]) == NULL, "removed twice");
+    check_lookups(&table, ITEMS / 2, ITEMS);
+
+    // Duplicate key: the older item is found first.
+    link_init(&items[0].hash_link);
+    items[0].owner = &owners[ITEMS - 1];
+    hash_table_insert(&table, &items[0].hash_link);
+    ktest_assert(find(&table, &owners[ITEMS - 1]) == &items[ITEMS - 1], "newer duplicate found");
+    hash_table_remove(&table, &items[ITEMS - 1].hash_link);
+    ktest_assert(find(&table, &owners[ITEMS - 1]) == &items[0], "duplicate not found");
+    hash_table_remove(&table, &items[0].hash_link);
+    items[0].owner = &owners[0];
+
+    // Single bucket degenerates to a list.
+    list_t single_bucket;
+    hash_table_resize(&table, &single_bucket, 1);
+    check_lookups(&table, ITEMS / 2, ITEMS - 1);
+}
+
+static void benchmark(void) {
+    hash_table_t table;
+    hash_table_init(&table, buckets, BUCKETS, &ops);
+    list_t list;
+    list_init(&list);
+    for (int i = 0; i < ITEMS; i++) {
+        link_init(&items[i].hash_link);
+        hash_table_insert(&table, &items[i].hash_link);
+        list_append(&list, &items[i].list_link);
+    }
+
+    uint32_t found = 0;
+    unative_t start = cp0_read_count();
+    for (int i = 0; i < ITEMS; i++) {
+        found += (find(&table, &owners[i]) != NULL);
+    }
+    unative_t table_cycles = cp0_read_count() - start;
+
+    // Every 16th key, otherwise the scan would take too long.
+    start = cp0_read_count();
+    for (int i = 0; i < ITEMS; i += ITEMS / SCAN_LOOKUPS) {
+        list_foreach(list, item_t, list_link, item) {
+            if (item->owner == &owners[i]) {
+                found++;
+                break;
+            }
+        }
+    }
+    unative_t scan_cycles = cp0_read_count() - start;
+
+    ktest_assert(found == ITEMS + SCAN_LOOKUPS, "found %u items", found);
+
+    printk("hash table: %u lookups among %u items in %u cycles (%u cycles/lookup)\n",
+            ITEMS, ITEMS, table_cycles, table_cycles / ITEMS);
+    printk("list scan: %u lookups among %u items in %u cycles (%u cycles/lookup)\n",
+            SCAN_LOOKUPS, ITEMS, scan_cycles, scan_cycles / SCAN_LOOKUPS);
+}
+
+void kernel_test(void) {
+    ktest_start("adt/hash_table");
+
+    for (int i = 0; i < ITEMS; i++) {
+        items[i].owner = &owners[i];
+        link_init(&items[i].hash_link);
+        link_init(&items[i].list_link);
+    }
+
+    check_correctness();
+    benchmark();
+
+    ktest_passed();
+}
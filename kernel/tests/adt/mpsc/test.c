@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Test of the multi-producer single-consumer ring. Several producer threads
+ * push items tagged with their index, the main thread consumes them and
+ * checks that items of each producer arrive in order and none is lost.
+ */
+
+#include <adt/ring.h>
+#include <ktest.h>
+#include <proc/thread.h>
+
+#define CAPACITY 16
+#define PRODUCERS 4
+#define ITEMS 200
+
+#define MAKE_ITEM(producer, index) ((void*)(((producer) << 16) | (index)))
+#define ITEM_PRODUCER(item) (((uintptr_t)(item)) >> 16)
+#define ITEM_INDEX(item) (((uintptr_t)(item)) & 0xffff)
+
+static mpsc_ring_slot_t slots[CAPACITY];
+static mpsc_ring_t ring;
+
+static void* producer(void* arg) {
+    uintptr_t producer_index = (uintptr_t)arg;
+    for (uintptr_t i = 0; i < ITEMS; i++) {
+        while (!mpsc_ring_push(&ring, MAKE_ITEM(producer_index, i))) {
+            thread_yield();
+        }
+        if ((i % 3) == 0) {
+            thread_yield();
+        }
+    }
+    return NULL;
+}
+
+void kernel_test(void) {
+    ktest_start("adt/mpsc");
+
+    mpsc_ring_init(&ring, slots, CAPACITY);
+
+    void* item;
+    ktest_assert(!mpsc_ring_pop(&ring, &item), "pop from empty ring shall fail");
+    for (uintptr_t i = 0; i < CAPACITY; i++) {
+        ktest_assert(mpsc_ring_push(&ring, MAKE_ITEM(0, i)), "push failed");
+    }
+    ktest_assert(!mpsc_ring_push(&ring, NULL), "push to full ring shall fail");
+    for (uintptr_t i = 0; i < CAPACITY; i++) {
+        ktest_assert(mpsc_ring_pop(&ring, &item), "pop failed");
+        ktest_assert(ITEM_INDEX(item) == i, "items out of order");
+    }
+
+    thread_t* threads[PRODUCERS];
+    for (uintptr_t i = 0; i < PRODUCERS; i++) {
+        errno_t err = thread_create(&threads[i], producer, (void*)i, 0, "producer");
+        ktest_assert_errno(err, "thread_create");
+    }
+
+    uintptr_t next_index[PRODUCERS] = { 0 };
+    for (int received = 0; received < PRODUCERS * ITEMS;) {
+        if (!mpsc_ring_pop(&ring, &item)) {
+            thread_yield();
+            continue;
+        }
+        uintptr_t producer_index = ITEM_PRODUCER(item);
+        ktest_assert(producer_index < PRODUCERS, "bad item %p", item);
+        ktest_assert(ITEM_INDEX(item) == next_index[producer_index],
+                "producer %u: got item %u, expected %u", producer_index,
+                ITEM_INDEX(item), next_index[producer_index]);
+        next_index[producer_index]++;
+        received++;
+    }
+
+    for (int i = 0; i < PRODUCERS; i++) {
+        errno_t err = thread_join(threads[i], NULL);
+        ktest_assert_errno(err, "thread_join");
+    }
+    ktest_assert(!mpsc_ring_pop(&ring, &item), "ring shall be empty");
+
+    ktest_passed();
+}
@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Test of the red-black tree. Items are inserted and removed in
+ * pseudo-random order and the tree invariants are checked after every
+ * batch. Finally, lookups of all keys are timed in the tree and by
+ * walking a list of the same items.
+ */
+
+#include <adt/list.h>
+#include <adt/rbtree.h>
+#include <drivers/cp0.h>
+#include <ktest.h>
+
+#define ITEMS 500
+#define BATCH 50
+
+typedef struct {
+    int key;
+    rb_node_t node;
+    link_t link;
+    bool inserted;
+} item_t;
+
+static item_t items[ITEMS];
+
+static int compare_items(const rb_node_t* a, const rb_node_t* b) {
+    return rb_item(a, item_t, node)->key - rb_item(b, item_t, node)->key;
+}
+
+static int compare_key(const void* key, const rb_node_t* node) {
+    return *(const int*)key - rb_item(node, item_t, node)->key;
+}
+
+static uint32_t random_state = 12345;
+
+static uint32_t next_random(void) {
+    random_state = random_state * 1103515245 + 12345;
+    return random_state >> 8;
+}
+
+/** Check the subtree, return its black height. */
+static int check_subtree(rb_node_t* node, rb_node_t* parent, size_t* count) {
+    if (node == NULL) {
+        return 1;
+    }
+    ktest_assert(node->parent == parent, "broken parent link");
+    if (node->red) {
+        ktest_assert(!rb_node_is_red(node->left) && !rb_node_is_red(node->right),
+                "red node with a red child");
+    }
+    if (node->left != NULL) {
+        ktest_assert(compare_items(node->left, node) <= 0, "left child is bigger");
+    }
+    if (node->right != NULL) {
+        ktest_assert(compare_items(node->right, node) >= 0, "right child is smaller");
+    }
+
+    int left_height = check_subtree(node->left, node, count);
+    int right_height = check_subtree(node->right, node, count);
+    ktest_assert(left_height == right_height, "black heights %d and %d", left_height, right_height);
+
+    (*count)++;
+    return left_height + (node->red ? 0 : 1);
+}
+
+static void check_tree(rb_tree_t* tree, size_t expected_count) {
+    size_t count = 0;
+    ktest_assert(!rb_node_is_red(tree->root), "red root");
+    check_subtree(tree->root, NULL, &count);
+    ktest_assert(count == expected_count, "%u nodes instead of %u", count, expected_count);
+
+    // In-order walk must be sorted both ways.
+    int previous = -1;
+    size_t walked = 0;
+    rb_tree_foreach(tree, item_t, node, it) {
+        ktest_assert(it->key >= previous, "walk not sorted");
+        previous = it->key;
+        walked++;
+    }
+    ktest_assert(walked == expected_count, "walked %u nodes", walked);
+
+    walked = 0;
+    for (rb_node_t* node = rb_tree_last(tree); node != NULL; node = rb_node_prev(node)) {
+        walked++;
+    }
+    ktest_assert(walked == expected_count, "walked back %u nodes", walked);
+}
+
+void kernel_test(void) {
+    ktest_start("adt/rbtree");
+
+    rb_tree_t tree;
+    rb_tree_init(&tree);
+    check_tree(&tree, 0);
+    ktest_assert(rb_tree_is_empty(&tree), "new tree not empty");
+
+    // Keys are even so that odd keys are never found; some are duplicate.
+    for (int i = 0; i < ITEMS; i++) {
+        items[i].key = (next_random() % (ITEMS * 2)) * 2;
+        items[i].inserted = false;
+    }
+
+    size_t count = 0;
+    for (int i = 0; i < ITEMS; i++) {
+        rb_tree_insert(&tree, &items[i].node, compare_items);
+        items[i].inserted = true;
+        count++;
+        if ((i % BATCH) == 0) {
+            check_tree(&tree, count);
+        }
+    }
+    check_tree(&tree, count);
+
+    for (int i = 0; i < ITEMS; i++) {
+        rb_node_t* found = rb_tree_find(&tree, &items[i].key, compare_key);
+        ktest_assert(found != NULL, "key %d not found", items[i].key);
+        ktest_assert(rb_item(found, item_t, node)->key == items[i].key, "wrong item found");
+
+        int missing = items[i].key + 1;
+        ktest_assert(rb_tree_find(&tree, &missing, compare_key) == NULL, "key %d found", missing);
+        rb_node_t* bound = rb_tree_lower_bound(&tree, &missing, compare_key);
+        ktest_assert((bound == NULL) || (rb_item(bound, item_t, node)->key > missing),
+                "lower bound of %d", missing);
+    }
+
+    // Remove a random half, then put some back, then remove everything.
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < ITEMS; i++) {
+            bool remove = (round == 2) || (next_random() % 2 == 0);
+            if (items[i].inserted && remove) {
+                rb_tree_remove(&tree, &items[i].node);
+                items[i].inserted = false;
+                count--;
+            } else if (!items[i].inserted && (round == 1) && !remove) {
+                rb_tree_insert(&tree, &items[i].node, compare_items);
+                items[i].inserted = true;
+                count++;
+            }
+            if ((i % BATCH) == 0) {
+                check_tree(&tree, count);
+            }
+        }
+        check_tree(&tree, count);
+    }
+    ktest_assert(rb_tree_is_empty(&tree), "tree not empty at the end");
+
+    // Lookup benchmark: the same items in the tree and in a list.
+    list_t list;
+    list_init(&list);
+    for (int i = 0; i < ITEMS; i++) {
+        items[i].key = i;
+        rb_tree_insert(&tree, &items[i].node, compare_items);
+        link_init(&items[i].link);
+        list_append(&list, &items[i].link);
+    }
+
+    unative_t start = cp0_read_count();
+    for (int key = 0; key < ITEMS; key++) {
+        rb_node_t* found = rb_tree_find(&tree, &key, compare_key);
+        ktest_assert(found != NULL, "key %d not found", key);
+    }
+    unative_t tree_cycles = (cp0_read_count() - start) / ITEMS;
+
+    start = cp0_read_count();
+    for (int key = 0; key < ITEMS; key++) {
+        item_t* found = NULL;
+        list_foreach(list, item_t, link, it) {
+            if (it->key == key) {
+                found = it;
+                break;
+            }
+        }
+        ktest_assert(found != NULL, "key %d not found", key);
+    }
+    unative_t list_cycles = (cp0_read_count() - start) / ITEMS;
+
+    start = cp0_read_count();
+    for (int i = 0; i < ITEMS; i++) {
+        rb_tree_remove(&tree, &items[i].node);
+    }
+    for (int i = 0; i < ITEMS; i++) {
+        rb_tree_insert(&tree, &items[i].node, compare_items);
+    }
+    unative_t update_cycles = (cp0_read_count() - start) / (2 * ITEMS);
+
+    printk("lookup among %d items: %u cycles (tree), %u cycles (list); "
+           "%u cycles per tree insert/remove\n",
+            ITEMS, tree_cycles, list_cycles, update_cycles);
+
+    ktest_passed();
+}
@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Throughput benchmark of the ring buffers: push a batch of messages and
+ * pop them again, repeatedly, in a single thread. Reports messages (one push
+ * and one pop) per million cycles.
+ */
+
+#include <adt/ring.h>
+#include <drivers/cp0.h>
+#include <ktest.h>
+
+#define CAPACITY 64
+#define ROUNDS 100
+#define MESSAGES (CAPACITY * ROUNDS)
+
+static void* spsc_slots[CAPACITY];
+static spsc_ring_t spsc;
+
+static mpsc_ring_slot_t mpsc_slots[CAPACITY];
+static mpsc_ring_t mpsc;
+
+static void report(const char* name, unative_t cycles) {
+    unsigned long long per_mcycle = (unsigned long long)MESSAGES * 1000000 / cycles;
+    printk("%s: %u messages in %u cycles (%u messages/Mcycle)\n",
+            name, MESSAGES, cycles, (uint32_t)per_mcycle);
+}
+
+void kernel_test(void) {
+    ktest_start("adt/ring_throughput");
+
+    spsc_ring_init(&spsc, spsc_slots, CAPACITY);
+    mpsc_ring_init(&mpsc, mpsc_slots, CAPACITY);
+
+    uintptr_t checksum = 0;
+    void* item;
+
+    unative_t start = cp0_read_count();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (uintptr_t i = 0; i < CAPACITY; i++) {
+            spsc_ring_push(&spsc, (void*)i);
+        }
+        for (int i = 0; i < CAPACITY; i++) {
+            spsc_ring_pop(&spsc, &item);
+            checksum += (uintptr_t)item;
+        }
+    }
+    report("spsc", cp0_read_count() - start);
+
+    start = cp0_read_count();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (uintptr_t i = 0; i < CAPACITY; i++) {
+            mpsc_ring_push(&mpsc, (void*)i);
+        }
+        for (int i = 0; i < CAPACITY; i++) {
+            mpsc_ring_pop(&mpsc, &item);
+            checksum += (uintptr_t)item;
+        }
+    }
+    report("mpsc", cp0_read_count() - start);
+
+    uintptr_t expected = 2 * ROUNDS * (CAPACITY * (CAPACITY - 1) / 2);
+    ktest_assert(checksum == expected, "checksum %u != %u", checksum, expected);
+
+    ktest_passed();
+}
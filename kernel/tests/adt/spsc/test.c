@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Test of the single-producer single-consumer ring: basic operations
+ * (including wrap-around of the slot array) first, then passing items
+ * from a producer thread to a consumer thread.
+ */
+
+#include <adt/ring.h>
+#include <ktest.h>
+#include <proc/thread.h>
+
+#define CAPACITY 8
+#define ITEMS 500
+
+static void* slots[CAPACITY];
+static spsc_ring_t ring;
+
+static void* producer(void* ignored) {
+    for (uintptr_t i = 1; i <= ITEMS; i++) {
+        while (!spsc_ring_push(&ring, (void*)i)) {
+            thread_yield();
+        }
+    }
+    return NULL;
+}
+
+static void* consumer(void* ignored) {
+    for (uintptr_t i = 1; i <= ITEMS; i++) {
+        void* item;
+        while (!spsc_ring_pop(&ring, &item)) {
+            thread_yield();
+        }
+        ktest_assert((uintptr_t)item == i, "got %u instead of %u", item, i);
+    }
+    return NULL;
+}
+
+void kernel_test(void) {
+    ktest_start("adt/spsc");
+
+    spsc_ring_init(&ring, slots, CAPACITY);
+    ktest_assert(spsc_ring_is_empty(&ring), "ring shall be empty");
+
+    void* item;
+    ktest_assert(!spsc_ring_pop(&ring, &item), "pop from empty ring shall fail");
+
+    // Several laps so that positions wrap around the slot array.
+    for (uintptr_t lap = 0; lap < 3; lap++) {
+        for (uintptr_t i = 0; i < CAPACITY; i++) {
+            ktest_assert(spsc_ring_push(&ring, (void*)(lap * 100 + i)), "push failed");
+        }
+        ktest_assert(!spsc_ring_push(&ring, NULL), "push to full ring shall fail");
+        ktest_assert(spsc_ring_get_size(&ring) == CAPACITY, "ring shall be full");
+
+        for (uintptr_t i = 0; i < CAPACITY; i++) {
+            ktest_assert(spsc_ring_pop(&ring, &item), "pop failed");
+            ktest_assert((uintptr_t)item == lap * 100 + i, "items out of order");
+        }
+        ktest_assert(spsc_ring_is_empty(&ring), "ring shall be empty");
+    }
+
+    thread_t* producer_thread;
+    thread_t* consumer_thread;
+    errno_t err = thread_create(&producer_thread, producer, NULL, 0, "producer");
+    ktest_assert_errno(err, "thread_create(producer)");
+    err = thread_create(&consumer_thread, consumer, NULL, 0, "consumer");
+    ktest_assert_errno(err, "thread_create(consumer)");
+
+    err = thread_join(producer_thread, NULL);
+    ktest_assert_errno(err, "thread_join(producer)");
+    err = thread_join(consumer_thread, NULL);
+    ktest_assert_errno(err, "thread_join(consumer)");
+
+    ktest_assert(spsc_ring_is_empty(&ring), "ring shall be empty");
+
+    ktest_passed();
+}
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Benchmark of the kernel heap: a single allocation and release of small
+ * and bigger blocks, and a batch of allocations released in reverse order
+ * (which exercises block merging).
+ */
+
+#include <kbench.h>
+#include <mm/heap.h>
+
+#define BATCH 16
+
+void kernel_test(void) {
+    ktest_start("bench/heap");
+
+    void* batch[BATCH];
+    bool all_allocated = true;
+
+    kbench_run("heap/kmalloc_free_16", 4, 32, {
+        void* ptr = kmalloc(16);
+        all_allocated = all_allocated && (ptr != NULL);
+        kfree(ptr);
+    });
+
+    kbench_run("heap/kmalloc_free_1024", 4, 32, {
+        void* ptr = kmalloc(1024);
+        all_allocated = all_allocated && (ptr != NULL);
+        kfree(ptr);
+    });
+
+    kbench_run("heap/batch_16x64", 2, 16, {
+        for (int i = 0; i < BATCH; i++) {
+            batch[i] = kmalloc(64);
+            all_allocated = all_allocated && (batch[i] != NULL);
+        }
+        for (int i = BATCH - 1; i >= 0; i--) {
+            kfree(batch[i]);
+        }
+    });
+
+    ktest_assert(all_allocated, "out of memory");
+
+    ktest_passed();
+}
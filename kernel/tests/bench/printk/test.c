@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Benchmark of the formatting code. Output goes to a memory buffer so that
+ * the console does not dominate the numbers.
+ */
+
+#include <kbench.h>
+
+#define BUFFER_SIZE 128
+
+void kernel_test(void) {
+    ktest_start("bench/printk");
+
+    char buffer[BUFFER_SIZE];
+    size_t length = 0;
+
+    kbench_run("printk/snprintk_string", 4, 32, {
+        length += snprintk(buffer, BUFFER_SIZE, "%s", "Hello, World!");
+    });
+
+    kbench_run("printk/snprintk_decimal", 4, 32, {
+        length += snprintk(buffer, BUFFER_SIZE, "%d %u", -123456789, 4000000000U);
+    });
+
+    kbench_run("printk/snprintk_mixed", 4, 32, {
+        length += snprintk(buffer, BUFFER_SIZE, "[%08x] %-10s|%5d|%llu",
+                0xdeadbeef, "name", 42, 12345678901234ULL);
+    });
+
+    ktest_assert(length > 0, "nothing formatted");
+
+    ktest_passed();
+}
@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Benchmark of the scheduler: a yield with no other ready thread, a round
+ * of yields through a few ready threads, and thread create with join.
+ */
+
+#include <kbench.h>
+#include <proc/thread.h>
+
+#define BACKGROUND_THREADS 4
+
+static volatile bool terminate_background = false;
+
+static void* background_worker(void* ignored) {
+    while (!terminate_background) {
+        thread_yield();
+    }
+    return NULL;
+}
+
+static void* empty_worker(void* ignored) {
+    return NULL;
+}
+
+void kernel_test(void) {
+    ktest_start("bench/scheduler");
+
+    errno_t err;
+
+    kbench_run("scheduler/yield_alone", 4, 32, {
+        thread_yield();
+    });
+
+    kbench_run("scheduler/create_join", 4, 32, {
+        thread_t* thread;
+        err = thread_create(&thread, empty_worker, NULL, 0, "empty");
+        ktest_assert_errno(err, "thread_create");
+        err = thread_join(thread, NULL);
+        ktest_assert_errno(err, "thread_join");
+    });
+
+    thread_t* background[BACKGROUND_THREADS];
+    for (int i = 0; i < BACKGROUND_THREADS; i++) {
+        err = thread_create(&background[i], background_worker, NULL, 0, "background");
+        ktest_assert_errno(err, "thread_create(background)");
+    }
+
+    kbench_run("scheduler/yield_round_4", 4, 32, {
+        thread_yield();
+    });
+
+    terminate_background = true;
+    for (int i = 0; i < BACKGROUND_THREADS; i++) {
+        err = thread_join(background[i], NULL);
+        ktest_assert_errno(err, "thread_join(background)");
+    }
+
+    ktest_passed();
+}
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Basic channel test: non-blocking operations on a buffered channel, then
+ * blocking transfer through a buffered and through a rendezvous channel.
+ */
+
+#include <ktest.h>
+#include <proc/chan.h>
+#include <proc/thread.h>
+
+#define CAPACITY 4
+#define MESSAGES 100
+
+static void* sender(void* arg) {
+    chan_t* chan = arg;
+    for (uintptr_t i = 1; i <= MESSAGES; i++) {
+        chan_send(chan, (void*)i);
+    }
+    return NULL;
+}
+
+static void transfer(chan_t* chan, const char* name) {
+    thread_t* thread;
+    errno_t err = thread_create(&thread, sender, chan, 0, "sender");
+    ktest_assert_errno(err, "thread_create");
+
+    for (uintptr_t i = 1; i <= MESSAGES; i++) {
+        void* message = chan_recv(chan);
+        ktest_assert((uintptr_t)message == i, "%s: got %u instead of %u",
+                name, message, i);
+    }
+
+    err = thread_join(thread, NULL);
+    ktest_assert_errno(err, "thread_join");
+}
+
+void kernel_test(void) {
+    ktest_start("chan/basic");
+
+    chan_t* chan;
+    errno_t err = chan_create(&chan, CAPACITY);
+    ktest_assert_errno(err, "chan_create");
+
+    void* message;
+    ktest_assert(chan_try_recv(chan, &message) == EBUSY, "empty channel");
+    for (uintptr_t i = 0; i < CAPACITY; i++) {
+        err = chan_try_send(chan, (void*)i);
+        ktest_assert_errno(err, "chan_try_send");
+    }
+    ktest_assert(chan_try_send(chan, NULL) == EBUSY, "full channel");
+    for (uintptr_t i = 0; i < CAPACITY; i++) {
+        err = chan_try_recv(chan, &message);
+        ktest_assert_errno(err, "chan_try_recv");
+        ktest_assert((uintptr_t)message == i, "got %u instead of %u", message, i);
+    }
+
+    transfer(chan, "buffered");
+    chan_destroy(chan);
+
+    err = chan_create(&chan, 0);
+    ktest_assert_errno(err, "chan_create(0)");
+    ktest_assert(chan_try_send(chan, NULL) == EBUSY, "nobody is receiving");
+    transfer(chan, "rendezvous");
+    chan_destroy(chan);
+
+    ktest_passed();
+}
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Staged pipeline built from channels: a source generates numbers, two
+ * stages transform them and the main thread collects the results.
+ * A zero message terminates each stage.
+ */
+
+#include <ktest.h>
+#include <proc/chan.h>
+#include <proc/thread.h>
+
+#define STAGES 3
+#define CAPACITY 2
+#define ITEMS 200
+
+static chan_t* chans[STAGES];
+
+static void* source(void* ignored) {
+    for (uintptr_t i = 1; i <= ITEMS; i++) {
+        chan_send(chans[0], (void*)i);
+    }
+    chan_send(chans[0], (void*)0);
+    return NULL;
+}
+
+static void* stage(void* arg) {
+    uintptr_t index = (uintptr_t)arg;
+    while (true) {
+        uintptr_t value = (uintptr_t)chan_recv(chans[index]);
+        if (value == 0) {
+            break;
+        }
+        chan_send(chans[index + 1], (void*)(value * 2));
+    }
+    chan_send(chans[index + 1], (void*)0);
+    return NULL;
+}
+
+void kernel_test(void) {
+    ktest_start("chan/pipeline");
+
+    errno_t err;
+    for (int i = 0; i < STAGES; i++) {
+        err = chan_create(&chans[i], CAPACITY);
+        ktest_assert_errno(err, "chan_create");
+    }
+
+    thread_t* threads[STAGES];
+    err = thread_create(&threads[0], source, NULL, 0, "source");
+    ktest_assert_errno(err, "thread_create(source)");
+    for (uintptr_t i = 0; i < STAGES - 1; i++) {
+        err = thread_create(&threads[i + 1], stage, (void*)i, 0, "stage");
+        ktest_assert_errno(err, "thread_create(stage)");
+    }
+
+    uintptr_t expected = 1 << (STAGES - 1);
+    for (uintptr_t i = 1; i <= ITEMS; i++) {
+        uintptr_t value = (uintptr_t)chan_recv(chans[STAGES - 1]);
+        ktest_assert(value == i * expected, "got %u instead of %u", value, i * expected);
+    }
+    ktest_assert(chan_recv(chans[STAGES - 1]) == NULL, "expected terminator");
+
+    for (int i = 0; i < STAGES; i++) {
+        err = thread_join(threads[i], NULL);
+        ktest_assert_errno(err, "thread_join");
+        chan_destroy(chans[i]);
+    }
+
+    ktest_passed();
+}
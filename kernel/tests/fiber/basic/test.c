@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Runs a few fibers in two kernel threads. Fibers record the order in which
+ * they run: yields must be round-robin, fiber_switch must go directly to
+ * the target and fibers created by fibers must run too. The kernel threads
+ * also yield to each other from inside the fibers.
+ */
+
+#include <ktest.h>
+#include <proc/fiber.h>
+#include <proc/thread.h>
+
+#define ROUNDS 3
+#define TRACE_MAX 64
+
+typedef struct {
+    fiber_sched_t sched;
+    char trace[TRACE_MAX];
+    size_t trace_length;
+    fiber_t* last;
+} group_t;
+
+static group_t groups[2];
+
+static bool trace_equals(const char* a, const char* b) {
+    while ((*a != '\0') && (*a == *b)) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static void record(char c) {
+    group_t* group = (group_t*)fiber_get_current()->sched;
+    ktest_assert(group->trace_length < TRACE_MAX - 1, "trace too long");
+    group->trace[group->trace_length++] = c;
+}
+
+static void child(void* arg) {
+    record('c');
+}
+
+static void letter(void* arg) {
+    char c = (char)(uintptr_t)arg;
+    for (int i = 0; i < ROUNDS; i++) {
+        record(c);
+        thread_yield();
+        fiber_yield();
+    }
+}
+
+static void switcher(void* arg) {
+    group_t* group = arg;
+    record('S');
+    errno_t err = fiber_switch(group->last);
+    ktest_assert_errno(err, "fiber_switch");
+    record('s');
+
+    err = fiber_create(NULL, &group->sched, child, NULL, FIBER_STACK_SIZE_MIN);
+    ktest_assert_errno(err, "fiber_create(child)");
+}
+
+static void* runner(void* arg) {
+    group_t* group = arg;
+    fiber_sched_init(&group->sched);
+
+    errno_t err;
+    err = fiber_create(NULL, &group->sched, letter, (void*)'a', 0);
+    ktest_assert_errno(err, "fiber_create(a)");
+    err = fiber_create(NULL, &group->sched, switcher, group, 0);
+    ktest_assert_errno(err, "fiber_create(switcher)");
+    err = fiber_create(NULL, &group->sched, letter, (void*)'b', 0);
+    ktest_assert_errno(err, "fiber_create(b)");
+    err = fiber_create(&group->last, &group->sched, letter, (void*)'z', 0);
+    ktest_assert_errno(err, "fiber_create(z)");
+
+    ktest_assert(fiber_get_current() == NULL, "fiber outside of fiber_run");
+    fiber_run(&group->sched);
+    ktest_assert(fiber_get_current() == NULL, "fiber after fiber_run");
+    ktest_assert(group->sched.fiber_count == 0, "fibers left");
+
+    group->trace[group->trace_length] = '\0';
+    return NULL;
+}
+
+void kernel_test(void) {
+    ktest_start("fiber/basic");
+
+    fiber_sched_t sched;
+    fiber_sched_init(&sched);
+    fiber_t* fiber;
+    errno_t err = fiber_create(&fiber, &sched, child, NULL, FIBER_STACK_SIZE_MIN - 1);
+    ktest_assert(err == EINVAL, "too small stack accepted");
+    ktest_assert(fiber_switch(NULL) == EINVAL, "fiber_switch outside of fiber");
+
+    thread_t* threads[2];
+    for (int i = 0; i < 2; i++) {
+        err = thread_create(&threads[i], runner, &groups[i], 0, "runner");
+        ktest_assert_errno(err, "thread_create");
+    }
+    for (int i = 0; i < 2; i++) {
+        err = thread_join(threads[i], NULL);
+        ktest_assert_errno(err, "thread_join");
+    }
+
+    // Switcher takes the place of z in the queue, child is appended.
+    const char* expected = "aSzbsazbcazb";
+    for (int i = 0; i < 2; i++) {
+        ktest_assert(trace_equals(groups[i].trace, expected),
+                "fiber order %s, expected %s", groups[i].trace, expected);
+    }
+
+    ktest_passed();
+}
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Benchmark comparing a ping-pong of two kernel threads (thread_yield)
+ * with a ping-pong of two fibers (fiber_yield), then creates fibers with
+ * minimal stacks until the heap is exhausted (or MAX_FIBERS is reached)
+ * and runs all of them concurrently. The number reached is printed.
+ *
+ * The test only checks that everything ran, the cycle counts are printed
+ * for comparison.
+ */
+
+#include <drivers/cp0.h>
+#include <ktest.h>
+#include <proc/fiber.h>
+#include <proc/thread.h>
+
+#define SWITCHES 2000
+/** At least this many fibers must fit (about 280 KiB of heap). */
+#define MIN_FIBERS 500
+#define MAX_FIBERS 100000
+
+static volatile size_t switches = 0;
+static volatile size_t many_ran = 0;
+
+static void* thread_pinger(void* ignored) {
+    for (int i = 0; i < SWITCHES / 2; i++) {
+        switches++;
+        thread_yield();
+    }
+    return NULL;
+}
+
+static void fiber_pinger(void* ignored) {
+    for (int i = 0; i < SWITCHES / 2; i++) {
+        switches++;
+        fiber_yield();
+    }
+}
+
+static void short_fiber(void* ignored) {
+    fiber_yield();
+    many_ran++;
+}
+
+static void report(const char* name, unative_t cycles) {
+    printk("%s: %u switches in %u cycles (%u cycles/switch)\n",
+            name, SWITCHES, cycles, cycles / SWITCHES);
+}
+
+void kernel_test(void) {
+    ktest_start("fiber/throughput");
+
+    errno_t err;
+    thread_t* threads[2];
+    unative_t start = cp0_read_count();
+    for (int i = 0; i < 2; i++) {
+        err = thread_create(&threads[i], thread_pinger, NULL, 0, "pinger");
+        ktest_assert_errno(err, "thread_create");
+    }
+    for (int i = 0; i < 2; i++) {
+        err = thread_join(threads[i], NULL);
+        ktest_assert_errno(err, "thread_join");
+    }
+    report("threads", cp0_read_count() - start);
+    ktest_assert(switches == SWITCHES, "%u thread switches", switches);
+
+    fiber_sched_t sched;
+    fiber_sched_init(&sched);
+    switches = 0;
+    start = cp0_read_count();
+    for (int i = 0; i < 2; i++) {
+        err = fiber_create(NULL, &sched, fiber_pinger, NULL, FIBER_STACK_SIZE_MIN);
+        ktest_assert_errno(err, "fiber_create");
+    }
+    fiber_run(&sched);
+    report("fibers", cp0_read_count() - start);
+    ktest_assert(switches == SWITCHES, "%u fiber switches", switches);
+
+    size_t created = 0;
+    start = cp0_read_count();
+    while (created < MAX_FIBERS) {
+        err = fiber_create(NULL, &sched, short_fiber, NULL, FIBER_STACK_SIZE_MIN);
+        if (err == ENOMEM) {
+            break;
+        }
+        ktest_assert_errno(err, "fiber_create(many)");
+        created++;
+    }
+    fiber_run(&sched);
+    unative_t cycles = cp0_read_count() - start;
+    printk("%u concurrent fibers (%u B stacks) created, run and freed in %u cycles\n",
+            created, FIBER_STACK_SIZE_MIN, cycles);
+    ktest_assert(created >= MIN_FIBERS, "only %u fibers fit into memory", created);
+    ktest_assert(many_ran == created, "only %u of %u fibers ran", many_ran, created);
+
+    ktest_passed();
+}
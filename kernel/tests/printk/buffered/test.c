@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Test of buffered console output. Another thread prints more than fits
+ * into the log buffer while the test thread keeps yielding and checks
+ * afterwards that the output was not reordered. Finally, the cost of
+ * printk is measured in the buffered and in the synchronous mode.
+ */
+
+#include <drivers/cp0.h>
+#include <ktest.h>
+#include <proc/thread.h>
+
+#define LINES 200
+#define MEASURED_LINES 50
+
+static volatile bool writer_done = false;
+
+static void* writer(void* ignored) {
+    for (int i = 0; i < LINES; i++) {
+        printk("writer line %d of %d: the quick brown fox jumps over the lazy dog\n",
+                i + 1, LINES);
+        if ((i % 16) == 0) {
+            thread_yield();
+        }
+    }
+    writer_done = true;
+    return NULL;
+}
+
+static unative_t measure_printk(void) {
+    // Start with an empty buffer so that we do not pay for older output.
+    printk_flush();
+
+    unative_t start = cp0_read_count();
+    for (int i = 0; i < MEASURED_LINES; i++) {
+        printk("measured line %d: %x %u %s\n", i, 0xdead, 12345, "text");
+    }
+    return (cp0_read_count() - start) / MEASURED_LINES;
+}
+
+void kernel_test(void) {
+    ktest_start("printk/buffered");
+
+    thread_t* thread;
+    errno_t err = thread_create(&thread, writer, NULL, 0, "writer");
+    ktest_assert_errno(err, "thread_create");
+
+    while (!writer_done) {
+        thread_yield();
+    }
+    err = thread_join(thread, NULL);
+    ktest_assert_errno(err, "thread_join");
+
+    puts(KTEST_EXPECTED "After writer: 42.");
+    printk(KTEST_ACTUAL "After writer: %d.\n", 42);
+
+    unative_t buffered = measure_printk();
+    printk_set_sync(true);
+    unative_t sync = measure_printk();
+    printk_set_sync(false);
+
+    printk("printk: %u cycles/call buffered, %u cycles/call synchronous\n",
+            buffered, sync);
+
+    puts(KTEST_EXPECTED "Back to buffered: ok.");
+    printk(KTEST_ACTUAL "Back to buffered: %s.\n", "ok");
+
+    ktest_passed();
+}
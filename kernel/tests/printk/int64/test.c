@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#include <ktest.h>
+#include <lib/print.h>
+
+void kernel_test(void) {
+    puts(KTEST_EXPECTED "Trillion: 1000000000000.");
+    printk(KTEST_ACTUAL "Trillion: %llu.\n", 1000000000000ULL);
+
+    puts(KTEST_EXPECTED "Negative: -1234567890123456789.");
+    printk(KTEST_ACTUAL "Negative: %lld.\n", -1234567890123456789LL);
+
+    puts(KTEST_EXPECTED "LLONG_MIN = -9223372036854775808 ; LLONG_MAX = 9223372036854775807.");
+    printk(KTEST_ACTUAL "LLONG_MIN = %lld ; LLONG_MAX = %lld.\n",
+            (long long)0x8000000000000000ULL, 0x7fffffffffffffffLL);
+
+    puts(KTEST_EXPECTED "ULLONG_MAX = 18446744073709551615 = ffffffffffffffff.");
+    printk(KTEST_ACTUAL "ULLONG_MAX = %llu = %llx.\n", ~0ULL, ~0ULL);
+
+    puts(KTEST_EXPECTED "Hexadecimal: 123456789abcdef FEDCBA9876543210.");
+    printk(KTEST_ACTUAL "Hexadecimal: %llx %llX.\n", 0x123456789abcdefULL, 0xfedcba9876543210ULL);
+
+    puts(KTEST_EXPECTED "Octal: 1777777777777777777777 10000000000000.");
+    printk(KTEST_ACTUAL "Octal: %llo %llo.\n", ~0ULL, 0x8000000000ULL);
+
+    puts(KTEST_EXPECTED "Small: 0 42 -1 2a.");
+    printk(KTEST_ACTUAL "Small: %llu %lld %lld %llx.\n", 0ULL, 42LL, -1LL, 42ULL);
+
+    puts(KTEST_EXPECTED "Mixed: 7 4294967296 8.");
+    printk(KTEST_ACTUAL "Mixed: %d %llu %lu.\n", 7, 4294967296ULL, 8UL);
+
+    ktest_passed();
+}
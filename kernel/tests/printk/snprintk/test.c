@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Test of formatting into memory buffers: results are printed back
+ * with %s, truncation and returned lengths are checked directly.
+ */
+
+#include <ktest.h>
+#include <lib/print.h>
+
+static size_t str_length(const char* s) {
+    size_t length = 0;
+    while (s[length] != '\0') {
+        length++;
+    }
+    return length;
+}
+
+/** Sink counting lines and characters, nothing is stored. */
+typedef struct {
+    print_sink_t base;
+    size_t lines;
+} line_counter_t;
+
+static void line_counter_putchar(print_sink_t* sink, char c) {
+    if (c == '\n') {
+        ((line_counter_t*)sink)->lines++;
+    }
+}
+
+void kernel_test(void) {
+    char buffer[64];
+
+    size_t length = snprintk(buffer, sizeof(buffer), "%d-%s-%llx", -42, "abc", 0x123456789ULL);
+    puts(KTEST_EXPECTED "Formatted: -42-abc-123456789.");
+    printk(KTEST_ACTUAL "Formatted: %s.\n", buffer);
+    ktest_assert(length == 17, "length is %u", length);
+
+    char small[8];
+    length = snprintk(small, sizeof(small), "%s %u", "truncated", 12345);
+    puts(KTEST_EXPECTED "Truncated: truncat.");
+    printk(KTEST_ACTUAL "Truncated: %s.\n", small);
+    ktest_assert(length == 15, "length is %u", length);
+    ktest_assert(str_length(small) == sizeof(small) - 1, "not terminated");
+
+    length = snprintk(NULL, 0, "%05d", 7);
+    ktest_assert(length == 5, "length is %u", length);
+
+    // Several pieces into one buffer.
+    print_buffer_sink_t sink;
+    print_buffer_sink_init(&sink, buffer, sizeof(buffer));
+    for (int i = 0; i < 3; i++) {
+        fprintk(&sink.base, "[%d]", i);
+    }
+    print_buffer_sink_terminate(&sink);
+    puts(KTEST_EXPECTED "Pieces: [0][1][2].");
+    printk(KTEST_ACTUAL "Pieces: %s.\n", buffer);
+
+    line_counter_t counter = {
+        .base = { .putchar = line_counter_putchar, .length = 0 },
+        .lines = 0,
+    };
+    fprintk(&counter.base, "one\ntwo\n%s\n", "three");
+    ktest_assert(counter.lines == 3, "%u lines", counter.lines);
+    ktest_assert(counter.base.length == 14, "%u characters", counter.base.length);
+
+    ktest_passed();
+}
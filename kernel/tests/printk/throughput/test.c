@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Benchmark of integer formatting. First the conversion routines alone
+ * (no console output involved) and then whole printk calls printing
+ * a few numbers each. Conversion results are checked for a handful of
+ * values, the cycle counts are printed for comparison.
+ */
+
+#include <drivers/cp0.h>
+#include <ktest.h>
+
+#define CONVERSIONS 1000
+#define LINES 100
+
+static bool str_equals(const char* a, const char* b) {
+    while ((*a != '\0') && (*a == *b)) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static void check_conversion(uint32_t n, base_t base, const char* expected) {
+    char buf[33];
+    int len = uint32_to_str(n, base, buf, sizeof(buf));
+    ktest_assert(len >= 0, "conversion of %u failed", n);
+    buf[len] = '\0';
+    ktest_assert(str_equals(buf, expected), "%u in base %u: got %s, expected %s",
+            n, base, buf, expected);
+}
+
+static unative_t measure_conversion(base_t base) {
+    char buf[33];
+    uint32_t n = 0x9e3779b9;
+
+    unative_t start = cp0_read_count();
+    for (int i = 0; i < CONVERSIONS; i++) {
+        uint32_to_str(n, base, buf, sizeof(buf));
+        n = n * 1664525 + 1013904223;
+    }
+    return (cp0_read_count() - start) / CONVERSIONS;
+}
+
+void kernel_test(void) {
+    ktest_start("printk/throughput");
+
+    check_conversion(0, 10, "0");
+    check_conversion(7, 10, "7");
+    check_conversion(42, 10, "42");
+    check_conversion(100, 10, "100");
+    check_conversion(4294967295U, 10, "4294967295");
+    check_conversion(0xdeadbeef, 16, "deadbeef");
+    check_conversion(0, 16, "0");
+    check_conversion(255, 2, "11111111");
+    check_conversion(35, 36, "z");
+
+    puts(KTEST_EXPECTED "Padded: 00042 -0042 0000abcd.");
+    printk(KTEST_ACTUAL "Padded: %05d %05d %08x.\n", 42, -42, 0xabcd);
+
+    unative_t decimal = measure_conversion(10);
+    unative_t hexadecimal = measure_conversion(16);
+    unative_t octal = measure_conversion(8);
+    printk("uint32_to_str: %u cycles (base 10), %u cycles (base 16), %u cycles (base 8)\n",
+            decimal, hexadecimal, octal);
+
+    // Do not measure output that is already waiting in the buffer.
+    printk_flush();
+
+    unative_t start = cp0_read_count();
+    for (int i = 0; i < LINES; i++) {
+        printk("%u %d %x\n", 0x7fffffff - i, -i * 1000, i * 0x1234567);
+    }
+    unative_t cycles = cp0_read_count() - start;
+    printk("printk: %u lines in %u cycles (%u cycles/line)\n",
+            LINES, cycles, cycles / LINES);
+
+    ktest_passed();
+}
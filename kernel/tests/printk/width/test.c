@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+#include <ktest.h>
+#include <lib/print.h>
+
+void kernel_test(void) {
+    puts(KTEST_EXPECTED "Right: [   42] [  -42] [  2a].");
+    printk(KTEST_ACTUAL "Right: [%5d] [%5d] [%4x].\n", 42, -42, 0x2a);
+
+    puts(KTEST_EXPECTED "Left: [42   ] [-42  ] [2a  ].");
+    printk(KTEST_ACTUAL "Left: [%-5d] [%-5d] [%-4x].\n", 42, -42, 0x2a);
+
+    puts(KTEST_EXPECTED "Zeroes: [00042] [-0042] [002A].");
+    printk(KTEST_ACTUAL "Zeroes: [%05d] [%05d] [%04X].\n", 42, -42, 0x2a);
+
+    puts(KTEST_EXPECTED "Sign: [+5] [-5] [ 5].");
+    printk(KTEST_ACTUAL "Sign: [%+d] [%+d] [% d].\n", 5, -5, 5);
+
+    puts(KTEST_EXPECTED "Precision: [007] [    -007] [00a     ] [].");
+    printk(KTEST_ACTUAL "Precision: [%.3d] [%8.3d] [%-8.3x] [%.0d].\n", 7, -7, 0xa, 0);
+
+    puts(KTEST_EXPECTED "Strings: [  abc] [abc  ] [ab] [x  ].");
+    printk(KTEST_ACTUAL "Strings: [%5s] [%-5s] [%.2s] [%-3c].\n", "abc", "abc", "abc", 'x');
+
+    puts(KTEST_EXPECTED "Star: [    42] [42    ].");
+    printk(KTEST_ACTUAL "Star: [%*d] [%*d].\n", 6, 42, -6, 42);
+
+    puts(KTEST_EXPECTED "Wide: [       1000000000000].");
+    printk(KTEST_ACTUAL "Wide: [%20llu].\n", 1000000000000ULL);
+
+    ktest_passed();
+}
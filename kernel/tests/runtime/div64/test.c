@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Test and benchmark of 64-bit division (__udivdi3 and friends). Results
+ * are compared with a plain 64-step shift-subtract division for a few
+ * hundred pseudo-random operands of various widths, then cycles are
+ * measured for typical timestamp arithmetic (64-bit cycle counts divided
+ * by small constants) and for the reference loop.
+ */
+
+#include <drivers/cp0.h>
+#include <ktest.h>
+
+#define RANDOM_CHECKS 500
+#define ITERATIONS 200
+
+static unsigned long long reference_div(unsigned long long a,
+        unsigned long long b, unsigned long long* rem) {
+    unsigned long long res = 0;
+    *rem = 0;
+    for (int steps = 64; steps > 0; steps--) {
+        *rem = (*rem << 1) | (a >> 63);
+        res <<= 1;
+        if (*rem >= b) {
+            *rem -= b;
+            res |= 1;
+        }
+        a <<= 1;
+    }
+    return res;
+}
+
+static unsigned long long random_state = 88172645463325252ULL;
+
+static unsigned long long next_random(void) {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+static void check_division(unsigned long long a, unsigned long long b) {
+    unsigned long long expected_rem;
+    unsigned long long expected = reference_div(a, b, &expected_rem);
+    unsigned long long quotient = a / b;
+    unsigned long long rem = a % b;
+
+    ktest_assert((quotient == expected) && (rem == expected_rem),
+            "%x%08x / %x%08x",
+            (uint32_t)(a >> 32), (uint32_t)a, (uint32_t)(b >> 32), (uint32_t)b);
+}
+
+void kernel_test(void) {
+    ktest_start("runtime/div64");
+
+    check_division(0, 1);
+    check_division(1000, 7);
+    check_division(~0ULL, 1);
+    check_division(~0ULL, ~0ULL);
+    check_division(~0ULL, 0xffffffffULL);
+    check_division(0x123456789abcdefULL, 1ULL << 40);
+    check_division(0x123456789abcdefULL, 1000000);
+    check_division(0xfedcba9876543210ULL, 0x100000001ULL);
+
+    for (int i = 0; i < RANDOM_CHECKS; i++) {
+        unsigned long long a = next_random() >> (next_random() & 63);
+        unsigned long long b = next_random() >> (next_random() & 63);
+        check_division(a, (b == 0) ? 1 : b);
+    }
+
+    long long negative = -1000000000000LL;
+    ktest_assert(negative / 7 == -142857142857LL, "signed division");
+    ktest_assert(negative % 7 == -1, "signed remainder");
+    ktest_assert(-negative / -7 == -142857142857LL, "signed division by negative");
+
+    // Cycles spent so far widened to 64 bits, as a timestamp would be.
+    volatile unsigned long long timestamp = (1ULL << 36) + cp0_read_count();
+    volatile unsigned long long divisor = 1000;
+    volatile unsigned long long sink;
+    unsigned long long unused_rem;
+
+    unative_t start = cp0_read_count();
+    for (int i = 0; i < ITERATIONS; i++) {
+        sink = timestamp / divisor;
+    }
+    unative_t small = (cp0_read_count() - start) / ITERATIONS;
+
+    divisor = 1ULL << 20;
+    start = cp0_read_count();
+    for (int i = 0; i < ITERATIONS; i++) {
+        sink = timestamp / divisor;
+    }
+    unative_t power = (cp0_read_count() - start) / ITERATIONS;
+
+    divisor = 0x300000007ULL;
+    start = cp0_read_count();
+    for (int i = 0; i < ITERATIONS; i++) {
+        sink = timestamp / divisor;
+    }
+    unative_t wide = (cp0_read_count() - start) / ITERATIONS;
+
+    divisor = 1000;
+    start = cp0_read_count();
+    for (int i = 0; i < ITERATIONS; i++) {
+        sink = reference_div(timestamp, divisor, &unused_rem);
+    }
+    unative_t reference = (cp0_read_count() - start) / ITERATIONS;
+    (void)sink;
+
+    printk("64-bit division: %u cycles (by 1000), %u cycles (by 2^20), "
+           "%u cycles (by 34-bit number), %u cycles (shift-subtract loop)\n",
+            small, power, wide, reference);
+
+    ktest_passed();
+}
@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Benchmark of memory and string primitives against plain byte loops.
+ * Results are checked for all combinations of small offsets and a range
+ * of lengths first (including overlapping memmove in both directions),
+ * then cycles per call are printed for a 1 KiB block.
+ */
+
+#include <drivers/cp0.h>
+#include <ktest.h>
+#include <lib/string.h>
+
+#define BLOCK_SIZE 1024
+#define ROUNDS 20
+#define CHECK_LENGTH 70
+
+/* Keep the compiler from turning the reference loops into library calls. */
+#define BYTE_LOOP __attribute__((noinline, optimize("no-tree-loop-distribute-patterns")))
+
+static uint8_t source[BLOCK_SIZE + 8] __attribute__((aligned(8)));
+static uint8_t target[BLOCK_SIZE + 8] __attribute__((aligned(8)));
+static uint8_t expected[BLOCK_SIZE + 8] __attribute__((aligned(8)));
+
+BYTE_LOOP static void byte_copy(uint8_t* dest, const uint8_t* src, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dest[i] = src[i];
+    }
+}
+
+BYTE_LOOP static void byte_fill(uint8_t* dest, uint8_t value, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dest[i] = value;
+    }
+}
+
+BYTE_LOOP static size_t byte_strlen(const char* s) {
+    size_t length = 0;
+    while (s[length] != '\0') {
+        length++;
+    }
+    return length;
+}
+
+static void fill_pattern(uint8_t* buffer, size_t n, uint8_t seed) {
+    for (size_t i = 0; i < n; i++) {
+        buffer[i] = (uint8_t)(i * 7 + seed);
+    }
+}
+
+static void check_same(const char* what, size_t offset, size_t length) {
+    for (size_t i = 0; i < BLOCK_SIZE + 8; i++) {
+        ktest_assert(target[i] == expected[i], "%s (offset %u, length %u) differs at %u",
+                what, offset, length, i);
+    }
+}
+
+static void check_correctness(void) {
+    fill_pattern(source, BLOCK_SIZE + 8, 1);
+
+    for (size_t src_offset = 0; src_offset < 4; src_offset++) {
+        for (size_t dest_offset = 0; dest_offset < 4; dest_offset++) {
+            for (size_t length = 0; length < CHECK_LENGTH; length++) {
+                fill_pattern(target, BLOCK_SIZE + 8, 5);
+                fill_pattern(expected, BLOCK_SIZE + 8, 5);
+                memcpy(target + dest_offset, source + src_offset, length);
+                byte_copy(expected + dest_offset, source + src_offset, length);
+                check_same("memcpy", dest_offset, length);
+
+                memset(target + dest_offset, 0xa5, length);
+                byte_fill(expected + dest_offset, 0xa5, length);
+                check_same("memset", dest_offset, length);
+
+                // Shift the data within the buffer by a few bytes both ways.
+                size_t from = 16 + src_offset;
+                size_t to = 16 + dest_offset + ((length % 2) ? 5 : 0) - ((length % 3) ? 3 : 0);
+                fill_pattern(target, BLOCK_SIZE + 8, 3);
+                fill_pattern(expected, BLOCK_SIZE + 8, 3);
+                memmove(target + to, target + from, length);
+                byte_copy(source + BLOCK_SIZE / 2, expected + from, length);
+                byte_copy(expected + to, source + BLOCK_SIZE / 2, length);
+                fill_pattern(source, BLOCK_SIZE + 8, 1);
+                check_same("memmove", to, length);
+
+                ktest_assert(memcmp(target, expected, length) == 0, "memcmp of equal");
+                if (length > 0) {
+                    target[length - 1] = 0x10;
+                    expected[length - 1] = 0x20;
+                    ktest_assert(memcmp(target, expected, length) < 0, "memcmp of smaller");
+                    ktest_assert(memcmp(expected, target, length) > 0, "memcmp of bigger");
+                }
+
+                char* s = (char*)target + src_offset;
+                byte_fill((uint8_t*)s, 'x', length);
+                s[length] = '\0';
+                ktest_assert(strlen(s) == length, "strlen %u != %u", strlen(s), length);
+            }
+        }
+    }
+}
+
+void kernel_test(void) {
+    ktest_start("string/throughput");
+
+    check_correctness();
+
+    unative_t start = cp0_read_count();
+    for (int i = 0; i < ROUNDS; i++) {
+        byte_copy(target, source, BLOCK_SIZE);
+    }
+    unative_t copy_bytes = (cp0_read_count() - start) / ROUNDS;
+
+    start = cp0_read_count();
+    for (int i = 0; i < ROUNDS; i++) {
+        memcpy(target, source, BLOCK_SIZE);
+    }
+    unative_t copy_aligned = (cp0_read_count() - start) / ROUNDS;
+
+    start = cp0_read_count();
+    for (int i = 0; i < ROUNDS; i++) {
+        memcpy(target, source + 1, BLOCK_SIZE);
+    }
+    unative_t copy_unaligned = (cp0_read_count() - start) / ROUNDS;
+
+    start = cp0_read_count();
+    for (int i = 0; i < ROUNDS; i++) {
+        byte_fill(target, 0, BLOCK_SIZE);
+    }
+    unative_t fill_bytes = (cp0_read_count() - start) / ROUNDS;
+
+    start = cp0_read_count();
+    for (int i = 0; i < ROUNDS; i++) {
+        memset(target, 0, BLOCK_SIZE);
+    }
+    unative_t fill_words = (cp0_read_count() - start) / ROUNDS;
+
+    byte_fill(target, 'x', BLOCK_SIZE - 1);
+    target[BLOCK_SIZE - 1] = '\0';
+
+    start = cp0_read_count();
+    for (int i = 0; i < ROUNDS; i++) {
+        byte_strlen((const char*)target);
+    }
+    unative_t strlen_bytes = (cp0_read_count() - start) / ROUNDS;
+
+    start = cp0_read_count();
+    for (int i = 0; i < ROUNDS; i++) {
+        strlen((const char*)target);
+    }
+    unative_t strlen_words = (cp0_read_count() - start) / ROUNDS;
+
+    printk("copy of %u bytes: %u cycles (byte loop), %u cycles (memcpy), %u cycles (memcpy, unaligned)\n",
+            BLOCK_SIZE, copy_bytes, copy_aligned, copy_unaligned);
+    printk("fill of %u bytes: %u cycles (byte loop), %u cycles (memset)\n",
+            BLOCK_SIZE, fill_bytes, fill_words);
+    printk("length of %u characters: %u cycles (byte loop), %u cycles (strlen)\n",
+            BLOCK_SIZE - 1, strlen_bytes, strlen_words);
+
+    ktest_assert(copy_aligned < copy_bytes, "memcpy slower than a byte loop");
+    ktest_assert(fill_words < fill_bytes, "memset slower than a byte loop");
+
+    ktest_passed();
+}
@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Checks that mutex provides mutual exclusion. Each worker increments
+ * a shared counter in a non-atomic way (with yields in the critical
+ * section) so any other thread in the critical section would lose
+ * an update.
+ */
+
+#include <ktest.h>
+#include <proc/sync.h>
+#include <proc/thread.h>
+
+#define THREAD_COUNT 5
+#define LOOPS 20
+
+static mutex_t mutex;
+static volatile int counter = 0;
+static volatile int inside = 0;
+
+static void* worker(void* ignored) {
+    for (int i = 0; i < LOOPS; i++) {
+        mutex_lock(&mutex);
+
+        inside++;
+        ktest_assert(inside == 1, "%d threads inside critical section", inside);
+
+        int value = counter;
+        thread_yield();
+        counter = value + 1;
+
+        inside--;
+        mutex_unlock(&mutex);
+
+        thread_yield();
+    }
+
+    return NULL;
+}
+
+void kernel_test(void) {
+    ktest_start("sync/mutex");
+
+    errno_t err = mutex_init(&mutex);
+    ktest_assert_errno(err, "mutex_init");
+
+    ktest_assert(mutex_trylock(&mutex), "unlocked mutex shall be lockable");
+    ktest_assert(!mutex_trylock(&mutex), "locked mutex shall not be lockable");
+    mutex_unlock(&mutex);
+
+    thread_t* threads[THREAD_COUNT];
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        err = thread_create(&threads[i], worker, NULL, 0, "worker");
+        ktest_assert_errno(err, "thread_create");
+    }
+
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        err = thread_join(threads[i], NULL);
+        ktest_assert_errno(err, "thread_join");
+    }
+
+    ktest_assert(counter == THREAD_COUNT * LOOPS, "counter is %d", counter);
+
+    mutex_destroy(&mutex);
+
+    ktest_passed();
+}
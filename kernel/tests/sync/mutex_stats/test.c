@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Checks lock-hold statistics of the adaptive mutex (the test is always
+ * compiled with KERNEL_LOCK_STATS). Workers hold the mutex across a yield
+ * so other workers find it locked. With a single CPU the owner is never
+ * running when somebody else tries to lock, so nobody may acquire the
+ * mutex by spinning.
+ */
+
+#include <ktest.h>
+#include <proc/sync.h>
+#include <proc/thread.h>
+
+#define THREAD_COUNT 3
+#define LOOPS 10
+
+#ifndef KERNEL_LOCK_STATS
+#error This test requires KERNEL_LOCK_STATS
+#endif
+
+static mutex_t mutex;
+
+static void* worker(void* ignored) {
+    for (int i = 0; i < LOOPS; i++) {
+        mutex_lock(&mutex);
+        thread_yield();
+        mutex_unlock(&mutex);
+        thread_yield();
+    }
+    return NULL;
+}
+
+void kernel_test(void) {
+    ktest_start("sync/mutex_stats");
+
+    errno_t err = mutex_init(&mutex);
+    ktest_assert_errno(err, "mutex_init");
+
+    thread_t* threads[THREAD_COUNT];
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        err = thread_create(&threads[i], worker, NULL, 0, "worker");
+        ktest_assert_errno(err, "thread_create");
+    }
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        err = thread_join(threads[i], NULL);
+        ktest_assert_errno(err, "thread_join");
+    }
+
+    mutex_print_stats(&mutex, "test");
+
+    lock_stats_t* stats = &mutex.stats;
+    ktest_assert(stats->acquisitions == THREAD_COUNT * LOOPS,
+            "%u acquisitions recorded", stats->acquisitions);
+    ktest_assert(stats->contended > 0, "no contention recorded");
+    ktest_assert(stats->acquired_by_spinning == 0,
+            "%u acquisitions by spinning on single CPU",
+            stats->acquired_by_spinning);
+
+    size_t histogram_total = 0;
+    for (size_t i = 0; i < LOCK_STATS_BUCKETS; i++) {
+        histogram_total += stats->hold_histogram[i];
+    }
+    ktest_assert(histogram_total == stats->acquisitions,
+            "histogram has %u entries", histogram_total);
+
+    mutex_destroy(&mutex);
+
+    ktest_passed();
+}
@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Benchmark of a producer/consumer pair passing items through a single-slot
+ * mailbox. First the pair synchronizes by polling a volatile flag with
+ * thread_yield(), then by a pair of semaphores, and finally by semaphores
+ * where each side yields directly to the partner it has just woken-up.
+ * A few background threads stay ready the whole time so that polling (and
+ * plain wake-ups) have to go through them.
+ *
+ * The test only checks that all items were delivered, the cycle counts are
+ * printed for comparison.
+ */
+
+#include <drivers/cp0.h>
+#include <ktest.h>
+#include <proc/sync.h>
+#include <proc/thread.h>
+
+#define ITEMS 1000
+#define BACKGROUND_THREADS 3
+
+static volatile bool terminate_background = false;
+static sem_t done;
+
+static volatile int mailbox;
+static volatile bool mailbox_full = false;
+static volatile int polling_sum = 0;
+
+static sem_t mailbox_empty_sem;
+static sem_t mailbox_full_sem;
+static volatile int sem_sum = 0;
+
+static thread_t* volatile producer_thread;
+static thread_t* volatile consumer_thread;
+static volatile int handoff_sum = 0;
+
+static void* background_worker(void* ignored) {
+    while (!terminate_background) {
+        thread_yield();
+    }
+    return NULL;
+}
+
+static void* polling_producer(void* ignored) {
+    for (int i = 1; i <= ITEMS; i++) {
+        while (mailbox_full) {
+            thread_yield();
+        }
+        mailbox = i;
+        mailbox_full = true;
+    }
+    return NULL;
+}
+
+static void* polling_consumer(void* ignored) {
+    for (int i = 1; i <= ITEMS; i++) {
+        while (!mailbox_full) {
+            thread_yield();
+        }
+        polling_sum += mailbox;
+        mailbox_full = false;
+    }
+    sem_post(&done);
+    return NULL;
+}
+
+static void* sem_producer(void* ignored) {
+    for (int i = 1; i <= ITEMS; i++) {
+        sem_wait(&mailbox_empty_sem);
+        mailbox = i;
+        sem_post(&mailbox_full_sem);
+    }
+    return NULL;
+}
+
+static void* sem_consumer(void* ignored) {
+    for (int i = 1; i <= ITEMS; i++) {
+        sem_wait(&mailbox_full_sem);
+        sem_sum += mailbox;
+        sem_post(&mailbox_empty_sem);
+    }
+    sem_post(&done);
+    return NULL;
+}
+
+static void* handoff_producer(void* ignored) {
+    for (int i = 1; i <= ITEMS; i++) {
+        sem_wait(&mailbox_empty_sem);
+        mailbox = i;
+        sem_post(&mailbox_full_sem);
+        thread_yield_to(consumer_thread);
+    }
+    return NULL;
+}
+
+static void* handoff_consumer(void* ignored) {
+    for (int i = 1; i <= ITEMS; i++) {
+        sem_wait(&mailbox_full_sem);
+        handoff_sum += mailbox;
+        sem_post(&mailbox_empty_sem);
+        thread_yield_to(producer_thread);
+    }
+    sem_post(&done);
+    return NULL;
+}
+
+static unative_t run_pair(thread_entry_func_t producer,
+        thread_entry_func_t consumer, const char* name) {
+    unative_t start = cp0_read_count();
+
+    thread_t* thread;
+    errno_t err = thread_create(&thread, producer, NULL, 0, "producer");
+    ktest_assert_errno(err, "thread_create(producer)");
+    producer_thread = thread;
+    err = thread_create(&thread, consumer, NULL, 0, "consumer");
+    ktest_assert_errno(err, "thread_create(consumer)");
+    consumer_thread = thread;
+
+    sem_wait(&done);
+
+    unative_t cycles = cp0_read_count() - start;
+
+    err = thread_join(producer_thread, NULL);
+    ktest_assert_errno(err, "thread_join(producer)");
+    err = thread_join(consumer_thread, NULL);
+    ktest_assert_errno(err, "thread_join(consumer)");
+
+    printk("%s: %u items in %u cycles (%u cycles/item, %u items/Mcycle)\n",
+            name, ITEMS, cycles, cycles / ITEMS, ITEMS * 1000000 / cycles);
+
+    return cycles;
+}
+
+void kernel_test(void) {
+    ktest_start("sync/prodcons");
+
+    errno_t err;
+
+    err = sem_init(&done, 0);
+    ktest_assert_errno(err, "sem_init(done)");
+    err = sem_init(&mailbox_empty_sem, 1);
+    ktest_assert_errno(err, "sem_init(empty)");
+    err = sem_init(&mailbox_full_sem, 0);
+    ktest_assert_errno(err, "sem_init(full)");
+
+    thread_t* background[BACKGROUND_THREADS];
+    for (int i = 0; i < BACKGROUND_THREADS; i++) {
+        err = thread_create(&background[i], background_worker, NULL, 0, "background");
+        ktest_assert_errno(err, "thread_create(background)");
+    }
+
+    run_pair(polling_producer, polling_consumer, "yield-polling");
+    run_pair(sem_producer, sem_consumer, "semaphores");
+    run_pair(handoff_producer, handoff_consumer, "semaphores+yield_to");
+
+    terminate_background = true;
+    for (int i = 0; i < BACKGROUND_THREADS; i++) {
+        err = thread_join(background[i], NULL);
+        ktest_assert_errno(err, "thread_join(background)");
+    }
+
+    int expected_sum = ITEMS * (ITEMS + 1) / 2;
+    ktest_assert(polling_sum == expected_sum, "polling sum %d != %d", polling_sum, expected_sum);
+    ktest_assert(sem_sum == expected_sum, "semaphore sum %d != %d", sem_sum, expected_sum);
+    ktest_assert(handoff_sum == expected_sum, "handoff sum %d != %d", handoff_sum, expected_sum);
+
+    ktest_passed();
+}
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Basic semaphore test: workers block on a semaphore with zero value and
+ * are released one by one by the main thread. Blocked workers must not
+ * run at all (i.e. they are really parked, not spinning).
+ */
+
+#include <ktest.h>
+#include <proc/sync.h>
+#include <proc/thread.h>
+
+#define THREAD_COUNT 4
+#define SAFETY_LOOPS 10
+
+static sem_t sem;
+static volatile int passed = 0;
+
+static void* worker(void* ignored) {
+    sem_wait(&sem);
+    passed++;
+    return NULL;
+}
+
+void kernel_test(void) {
+    ktest_start("sync/sem");
+
+    errno_t err = sem_init(&sem, 2);
+    ktest_assert_errno(err, "sem_init");
+
+    err = sem_trywait(&sem);
+    ktest_assert_errno(err, "sem_trywait");
+    ktest_assert(sem_get_value(&sem) == 1, "value shall be 1");
+    sem_wait(&sem);
+    ktest_assert(sem_trywait(&sem) == EBUSY, "sem_trywait on zero shall fail");
+
+    thread_t* threads[THREAD_COUNT];
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        err = thread_create(&threads[i], worker, NULL, 0, "worker");
+        ktest_assert_errno(err, "thread_create");
+    }
+
+    for (int i = 0; i < SAFETY_LOOPS; i++) {
+        thread_yield();
+    }
+    ktest_assert(passed == 0, "%d threads passed closed semaphore", passed);
+
+    for (int released = 1; released <= THREAD_COUNT; released++) {
+        sem_post(&sem);
+        for (int i = 0; i < SAFETY_LOOPS; i++) {
+            thread_yield();
+        }
+        ktest_assert(passed == released, "%d threads passed, expected %d",
+                passed, released);
+    }
+    ktest_assert(sem_get_value(&sem) == 0, "value shall be 0");
+
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        err = thread_join(threads[i], NULL);
+        ktest_assert_errno(err, "thread_join");
+    }
+
+    sem_post(&sem);
+    ktest_assert(sem_get_value(&sem) == 1, "value shall be 1");
+
+    sem_destroy(&sem);
+
+    ktest_passed();
+}
@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Checks the fair scheduler (the test is always compiled with
+ * KERNEL_SCHED_FAIR).
+ *
+ * First, a heavy thread burns four times more cycles between yields than
+ * a light one. Round-robin would give the heavy thread four times more
+ * processor time, the fair scheduler must give them similar shares.
+ *
+ * Second, a sleeper is woken while two CPU-bound hogs are ready. It must run
+ * before any of them (round-robin would queue it behind both).
+ */
+
+#include <drivers/cp0.h>
+#include <ktest.h>
+#include <proc/thread.h>
+
+#ifndef KERNEL_SCHED_FAIR
+#error This test requires KERNEL_SCHED_FAIR
+#endif
+
+#define BURN_ITERATIONS 200
+#define SHARE_DURATION 2000000
+#define HOG_COUNT 2
+#define ROUNDS 5
+
+static volatile bool stop = false;
+static volatile unative_t burned = 0;
+static volatile size_t hog_slices = 0;
+
+static thread_t* main_thread;
+static volatile size_t sleeper_saw_slices;
+
+static void burn(int multiplier) {
+    for (int i = 0; i < BURN_ITERATIONS * multiplier; i++) {
+        burned++;
+    }
+}
+
+static void* burner(void* arg) {
+    int multiplier = (int)(uintptr_t)arg;
+    while (!stop) {
+        burn(multiplier);
+        thread_yield();
+    }
+    return NULL;
+}
+
+static void* hog(void* ignored) {
+    while (!stop) {
+        burn(4);
+        hog_slices++;
+        thread_yield();
+    }
+    return NULL;
+}
+
+static void* sleeper(void* ignored) {
+    for (int i = 0; i < ROUNDS; i++) {
+        thread_suspend();
+        sleeper_saw_slices = hog_slices;
+        thread_wakeup(main_thread);
+    }
+    return NULL;
+}
+
+static void wait_and_join(thread_t* thread) {
+    while (!thread_has_finished(thread)) {
+        thread_yield();
+    }
+    errno_t err = thread_join(thread, NULL);
+    ktest_assert_errno(err, "thread_join");
+}
+
+static void check_shares(void) {
+    thread_t* heavy;
+    thread_t* light;
+    errno_t err = thread_create(&heavy, burner, (void*)4, 0, "heavy");
+    ktest_assert_errno(err, "thread_create(heavy)");
+    err = thread_create(&light, burner, (void*)1, 0, "light");
+    ktest_assert_errno(err, "thread_create(light)");
+
+    unative_t start = cp0_read_count();
+    while (cp0_read_count() - start < SHARE_DURATION) {
+        thread_yield();
+    }
+    stop = true;
+    while (!thread_has_finished(heavy) || !thread_has_finished(light)) {
+        thread_yield();
+    }
+
+    thread_stats_t heavy_stats, light_stats;
+    err = thread_get_stats(heavy, &heavy_stats);
+    ktest_assert_errno(err, "thread_get_stats(heavy)");
+    err = thread_get_stats(light, &light_stats);
+    ktest_assert_errno(err, "thread_get_stats(light)");
+    printk("heavy: %u cycles in %u slices, light: %u cycles in %u slices\n",
+            heavy_stats.run_cycles, heavy_stats.switches,
+            light_stats.run_cycles, light_stats.switches);
+
+    ktest_assert(2 * heavy_stats.run_cycles < 3 * light_stats.run_cycles,
+            "heavy thread got too much processor time");
+    ktest_assert(2 * light_stats.run_cycles < 3 * heavy_stats.run_cycles,
+            "light thread got too much processor time");
+
+    wait_and_join(heavy);
+    wait_and_join(light);
+    stop = false;
+}
+
+static void check_wakeup_latency(void) {
+    main_thread = thread_get_current();
+
+    thread_t* sleeper_thread;
+    errno_t err = thread_create(&sleeper_thread, sleeper, NULL, 0, "sleeper");
+    ktest_assert_errno(err, "thread_create(sleeper)");
+    thread_t* hogs[HOG_COUNT];
+    for (int i = 0; i < HOG_COUNT; i++) {
+        err = thread_create(&hogs[i], hog, NULL, 0, "hog");
+        ktest_assert_errno(err, "thread_create(hog)");
+    }
+
+    for (size_t round = 0; round < ROUNDS; round++) {
+        // Let the hogs run for a while (and the sleeper fall asleep).
+        while ((hog_slices < (round + 1) * 4 * HOG_COUNT)
+                || (sleeper_thread->state != SUSPENDED)) {
+            thread_yield();
+        }
+
+        size_t woken_at_slices = hog_slices;
+        err = thread_wakeup(sleeper_thread);
+        ktest_assert_errno(err, "thread_wakeup(sleeper)");
+        thread_suspend();
+
+        ktest_assert(sleeper_saw_slices == woken_at_slices,
+                "round %u: %u hog slices before woken sleeper ran",
+                round, sleeper_saw_slices - woken_at_slices);
+    }
+
+    stop = true;
+    wait_and_join(sleeper_thread);
+    for (int i = 0; i < HOG_COUNT; i++) {
+        wait_and_join(hogs[i]);
+    }
+}
+
+void kernel_test(void) {
+    ktest_start("thread/fair_share");
+
+    check_shares();
+    check_wakeup_latency();
+
+    ktest_passed();
+}
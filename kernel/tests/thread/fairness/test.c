@@ -4,7 +4,8 @@
 /*
  * Trival test that the scheduler is fair. We run two threads where each
  * increments its own counter, yielding after each increment. We expect
- * that both counters would contain similar values.
+ * that both counters would contain similar values and that both threads
+ * got similar share of processor time.
  */
 
 #include <ktest.h>
@@ -55,6 +56,16 @@ void kernel_test(void) {
     terminate_one = true;
     terminate_two = true;
 
+    while (!thread_has_finished(thread_one) || !thread_has_finished(thread_two)) {
+        thread_yield();
+    }
+
+    thread_stats_t stats_one, stats_two;
+    err = thread_get_stats(thread_one, &stats_one);
+    ktest_assert_errno(err, "thread_get_stats(one)");
+    err = thread_get_stats(thread_two, &stats_two);
+    ktest_assert_errno(err, "thread_get_stats(two)");
+
     err = thread_join(thread_one, NULL);
     ktest_assert_errno(err, "thread_join(one)");
 
@@ -63,6 +74,10 @@ void kernel_test(void) {
 
     ktest_assert_in_range("thread_one counter", counter_one, LOOPS / 2, LOOPS * 2);
     ktest_assert_in_range("thread_two counter", counter_two, LOOPS / 2, LOOPS * 2);
+    ktest_assert((stats_one.run_cycles < 2 * stats_two.run_cycles)
+                    && (stats_two.run_cycles < 2 * stats_one.run_cycles),
+            "unfair CPU share (%u and %u cycles)",
+            stats_one.run_cycles, stats_two.run_cycles);
 
     ktest_passed();
 }
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Creates and joins far more short-lived threads than could fit into
+ * memory at once. Joined threads must be reclaimed (and recently joined
+ * ones reused directly). Also checks that only one thread can join
+ * another one.
+ */
+
+#include <ktest.h>
+#include <proc/thread.h>
+
+#define ROUNDS 1000
+#define BATCH 4
+
+static volatile bool release_worker = false;
+
+static void* short_worker(void* arg) {
+    return arg;
+}
+
+static void* waiting_worker(void* ignored) {
+    while (!release_worker) {
+        thread_yield();
+    }
+    return NULL;
+}
+
+static void* joining_worker(void* arg) {
+    errno_t err = thread_join((thread_t*)arg, NULL);
+    ktest_assert_errno(err, "thread_join(waiting)");
+    return NULL;
+}
+
+void kernel_test(void) {
+    ktest_start("thread/recycle");
+
+    errno_t err;
+    thread_t* first = NULL;
+    size_t reused = 0;
+
+    for (uintptr_t round = 0; round < ROUNDS; round++) {
+        thread_t* threads[BATCH];
+        for (uintptr_t i = 0; i < BATCH; i++) {
+            err = thread_create(&threads[i], short_worker, (void*)(round + i), 0, "short");
+            ktest_assert_errno(err, "thread_create");
+            if (first == NULL) {
+                first = threads[i];
+            } else if (threads[i] == first) {
+                reused++;
+            }
+        }
+        for (uintptr_t i = 0; i < BATCH; i++) {
+            void* retval;
+            err = thread_join(threads[i], &retval);
+            ktest_assert_errno(err, "thread_join");
+            ktest_assert((uintptr_t)retval == round + i, "bad return value");
+        }
+    }
+    printk("Created %u threads, memory of the first one reused %u times.\n",
+            ROUNDS * BATCH, reused);
+    ktest_assert(reused > 0, "joined threads are not reused");
+
+    thread_t* waiting;
+    err = thread_create(&waiting, waiting_worker, NULL, 0, "waiting");
+    ktest_assert_errno(err, "thread_create(waiting)");
+    thread_t* joining;
+    err = thread_create(&joining, joining_worker, waiting, 0, "joining");
+    ktest_assert_errno(err, "thread_create(joining)");
+
+    thread_yield();
+    thread_yield();
+    ktest_assert(thread_join(waiting, NULL) == EBUSY, "waiting is already joined");
+
+    release_worker = true;
+    err = thread_join(joining, NULL);
+    ktest_assert_errno(err, "thread_join(joining)");
+
+    ktest_passed();
+}
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Checks that thread_create flags select the stack size: stack pointer
+ * of each thread must lie inside its stack, a large stack must survive
+ * deep recursion and a lot of tiny threads must fit into memory at once
+ * (with default stacks they would take almost 1MB).
+ */
+
+#include <ktest.h>
+#include <proc/thread.h>
+
+#define TINY_THREAD_COUNT 200
+/* Frames take about 64B each, i.e. more than THREAD_STACK_SIZE in total. */
+#define RECURSION_DEPTH 150
+
+typedef struct {
+    size_t stack_size;
+    uintptr_t stack_pointer;
+} probe_t;
+
+static volatile bool terminate_tiny = false;
+
+static void* stack_probe(void* arg) {
+    probe_t* probe = arg;
+    probe->stack_size = thread_get_current()->stack_size;
+    probe->stack_pointer = (uintptr_t)&probe;
+    return NULL;
+}
+
+static unative_t recurse(unative_t depth) {
+    // Keep some data on the stack in each frame.
+    volatile unative_t frame[8];
+    for (unative_t i = 0; i < 8; i++) {
+        frame[i] = depth + i;
+    }
+    if (depth == 0) {
+        return frame[7];
+    }
+    return recurse(depth - 1) + frame[0];
+}
+
+static void* deep_worker(void* ignored) {
+    return (void*)recurse(RECURSION_DEPTH);
+}
+
+static void* tiny_worker(void* ignored) {
+    while (!terminate_tiny) {
+        thread_yield();
+    }
+    return NULL;
+}
+
+static void check_stack(unsigned int flags, size_t expected_size) {
+    probe_t probe;
+    thread_t* thread;
+    errno_t err = thread_create(&thread, stack_probe, &probe, flags, "probe");
+    ktest_assert_errno(err, "thread_create(probe)");
+
+    uintptr_t stack_bottom = (uintptr_t)thread + sizeof(thread_t);
+    uintptr_t stack_top = stack_bottom + expected_size;
+
+    err = thread_join(thread, NULL);
+    ktest_assert_errno(err, "thread_join(probe)");
+
+    ktest_assert(probe.stack_size == expected_size,
+            "flags %x: stack size %u != %u", flags, probe.stack_size, expected_size);
+    ktest_assert((probe.stack_pointer > stack_bottom) && (probe.stack_pointer < stack_top),
+            "flags %x: stack pointer %p outside of stack", flags, (void*)probe.stack_pointer);
+}
+
+void kernel_test(void) {
+    ktest_start("thread/stack_sizes");
+
+    check_stack(THREAD_FLAG_STACK_DEFAULT, THREAD_STACK_SIZE);
+    check_stack(THREAD_FLAG_STACK_TINY, THREAD_STACK_SIZE_TINY);
+    check_stack(THREAD_FLAG_STACK_SMALL, THREAD_STACK_SIZE_SMALL);
+    check_stack(THREAD_FLAG_STACK_LARGE, THREAD_STACK_SIZE_LARGE);
+
+    thread_t* thread;
+    errno_t err = thread_create(&thread, stack_probe, NULL, 0x100, "invalid");
+    ktest_assert(err == EINVAL, "unknown flags accepted");
+
+    void* retval;
+    err = thread_create(&thread, deep_worker, NULL, THREAD_FLAG_STACK_LARGE, "deep");
+    ktest_assert_errno(err, "thread_create(deep)");
+    err = thread_join(thread, &retval);
+    ktest_assert_errno(err, "thread_join(deep)");
+    unative_t expected = RECURSION_DEPTH * (RECURSION_DEPTH + 1) / 2 + 7;
+    ktest_assert((unative_t)retval == expected, "bad recursion result");
+
+    static thread_t* tiny[TINY_THREAD_COUNT];
+    for (int i = 0; i < TINY_THREAD_COUNT; i++) {
+        err = thread_create(&tiny[i], tiny_worker, NULL, THREAD_FLAG_STACK_TINY, "tiny");
+        ktest_assert_errno(err, "thread_create(tiny)");
+    }
+    terminate_tiny = true;
+    for (int i = 0; i < TINY_THREAD_COUNT; i++) {
+        err = thread_join(tiny[i], NULL);
+        ktest_assert_errno(err, "thread_join(tiny)");
+    }
+
+    ktest_passed();
+}
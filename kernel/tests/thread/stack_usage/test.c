@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Checks stack high-water-mark tracking: a thread that recursed deeper
+ * must report higher stack usage and the usage must never exceed the
+ * stack size. The usage is queried on finished (but not yet joined)
+ * threads.
+ */
+
+#include <ktest.h>
+#include <proc/thread.h>
+
+#define SHALLOW_DEPTH 2
+#define DEEP_DEPTH 40
+
+static unative_t recurse(unative_t depth) {
+    volatile unative_t frame[8];
+    for (unative_t i = 0; i < 8; i++) {
+        frame[i] = depth + i;
+    }
+    if (depth == 0) {
+        return frame[7];
+    }
+    return recurse(depth - 1) + frame[0];
+}
+
+static void* worker(void* arg) {
+    return (void*)recurse((unative_t)arg);
+}
+
+static size_t measure(unative_t depth) {
+    thread_t* thread;
+    errno_t err = thread_create(&thread, worker, (void*)depth, 0, "worker");
+    ktest_assert_errno(err, "thread_create");
+
+    while (!thread_has_finished(thread)) {
+        thread_yield();
+    }
+
+    size_t usage = thread_get_stack_usage(thread);
+    ktest_assert(usage > sizeof(context_t), "usage %u too small", usage);
+    ktest_assert(usage < thread->stack_size, "usage %u over stack size", usage);
+
+    err = thread_join(thread, NULL);
+    ktest_assert_errno(err, "thread_join");
+
+    printk("Recursion depth %u used %u bytes of stack.\n", depth, usage);
+    return usage;
+}
+
+void kernel_test(void) {
+    ktest_start("thread/stack_usage");
+
+    size_t shallow = measure(SHALLOW_DEPTH);
+    size_t deep = measure(DEEP_DEPTH);
+
+    // Each extra frame holds at least the 8 local words.
+    size_t min_difference = (DEEP_DEPTH - SHALLOW_DEPTH) * 8 * sizeof(unative_t);
+    ktest_assert(deep >= shallow + min_difference,
+            "deep recursion used %u bytes, shallow %u", deep, shallow);
+
+    // Memory of the deep thread is reused but the stack is painted again.
+    size_t again = measure(SHALLOW_DEPTH);
+    ktest_assert(again == shallow, "reused stack reports %u (expected %u)",
+            again, shallow);
+
+    ktest_passed();
+}
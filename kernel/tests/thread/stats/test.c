@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Checks per-thread CPU accounting: a CPU hog burns cycles between yields,
+ * a light thread only yields and a sleeper suspends itself a few times.
+ * The hog must have the highest run time and the switch counters must
+ * match what the threads did.
+ */
+
+#include <ktest.h>
+#include <proc/thread.h>
+
+#define LOOPS 10
+#define BURN_ITERATIONS 1000
+
+static volatile unative_t burned = 0;
+
+static void* hog(void* ignored) {
+    for (int i = 0; i < LOOPS; i++) {
+        for (int j = 0; j < BURN_ITERATIONS; j++) {
+            burned++;
+        }
+        thread_yield();
+    }
+    return NULL;
+}
+
+static void* light(void* ignored) {
+    for (int i = 0; i < LOOPS; i++) {
+        thread_yield();
+    }
+    return NULL;
+}
+
+static void* sleeper(void* ignored) {
+    for (int i = 0; i < LOOPS; i++) {
+        thread_suspend();
+    }
+    return NULL;
+}
+
+static void get_stats(thread_t* thread, thread_stats_t* stats) {
+    errno_t err = thread_get_stats(thread, stats);
+    ktest_assert_errno(err, "thread_get_stats");
+    printk("%pT\n", thread);
+}
+
+void kernel_test(void) {
+    ktest_start("thread/stats");
+
+    thread_stats_t stats;
+    ktest_assert(thread_get_stats(NULL, &stats) == EINVAL, "NULL thread accepted");
+
+    errno_t err;
+    thread_t* threads[3];
+    err = thread_create(&threads[0], hog, NULL, 0, "hog");
+    ktest_assert_errno(err, "thread_create(hog)");
+    err = thread_create(&threads[1], light, NULL, 0, "light");
+    ktest_assert_errno(err, "thread_create(light)");
+    err = thread_create(&threads[2], sleeper, NULL, 0, "sleeper");
+    ktest_assert_errno(err, "thread_create(sleeper)");
+
+    while (!thread_has_finished(threads[2])) {
+        thread_wakeup(threads[2]);
+        thread_yield();
+    }
+    while (!thread_has_finished(threads[0]) || !thread_has_finished(threads[1])) {
+        thread_yield();
+    }
+
+    thread_stats_t hog_stats, light_stats, sleeper_stats;
+    get_stats(threads[0], &hog_stats);
+    get_stats(threads[1], &light_stats);
+    get_stats(threads[2], &sleeper_stats);
+
+    ktest_assert(hog_stats.run_cycles > light_stats.run_cycles,
+            "hog ran %u cycles, light thread %u", hog_stats.run_cycles, light_stats.run_cycles);
+    ktest_assert(hog_stats.run_cycles > sleeper_stats.run_cycles,
+            "hog ran %u cycles, sleeper %u", hog_stats.run_cycles, sleeper_stats.run_cycles);
+
+    // Each yield is an involuntary switch, finishing is a voluntary one.
+    ktest_assert(light_stats.involuntary_switches == LOOPS,
+            "light thread: %u involuntary switches", light_stats.involuntary_switches);
+    ktest_assert(light_stats.voluntary_switches == 1,
+            "light thread: %u voluntary switches", light_stats.voluntary_switches);
+    ktest_assert(light_stats.switches == LOOPS + 1,
+            "light thread: %u switches", light_stats.switches);
+    ktest_assert(sleeper_stats.voluntary_switches == LOOPS + 1,
+            "sleeper: %u voluntary switches", sleeper_stats.voluntary_switches);
+
+    thread_stats_t my_stats;
+    err = thread_get_stats(thread_get_current(), &my_stats);
+    ktest_assert_errno(err, "thread_get_stats(current)");
+    ktest_assert(my_stats.switches > 0, "current thread never switched in");
+
+    for (int i = 0; i < 3; i++) {
+        err = thread_join(threads[i], NULL);
+        ktest_assert_errno(err, "thread_join");
+    }
+
+    ktest_passed();
+}
@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Checks thread-local storage: several threads (and fibers inside one of
+ * them) write their own values into reserved TLS areas, yield and check
+ * that nobody else changed them. Also checks that TLS starts zeroed and
+ * that reservations are limited by THREAD_TLS_SIZE.
+ */
+
+#include <ktest.h>
+#include <proc/fiber.h>
+#include <proc/thread.h>
+#include <proc/tls.h>
+
+#define THREAD_COUNT 4
+#define LOOPS 10
+
+typedef struct {
+    unative_t id;
+    unative_t counter;
+} per_thread_t;
+
+static size_t per_thread_offset;
+static size_t flag_offset;
+
+static void check_tls(unative_t id) {
+    per_thread_t* mine = tls_get(per_thread_offset);
+    ktest_assert(tls_get_block() == thread_get_current()->tls,
+            "$gp does not point to TLS of %pT", thread_get_current());
+    ktest_assert(mine->id == 0, "TLS not zeroed (id %u)", mine->id);
+
+    mine->id = id;
+    for (unative_t i = 0; i < LOOPS; i++) {
+        mine->counter++;
+        thread_yield();
+        ktest_assert(mine->id == id, "TLS id changed to %u (expected %u)", mine->id, id);
+        ktest_assert(mine->counter == i + 1, "TLS counter changed");
+    }
+}
+
+static void fiber_worker(void* ignored) {
+    // Fibers share TLS with their kernel thread.
+    bool* flag = tls_get(flag_offset);
+    *flag = true;
+    fiber_yield();
+    ktest_assert(tls_get_block() == thread_get_current()->tls, "fiber has different TLS");
+}
+
+static void* worker(void* arg) {
+    check_tls((unative_t)arg);
+
+    if ((unative_t)arg == 1) {
+        fiber_sched_t sched;
+        fiber_sched_init(&sched);
+        for (int i = 0; i < 2; i++) {
+            errno_t err = fiber_create(NULL, &sched, fiber_worker, NULL, 0);
+            ktest_assert_errno(err, "fiber_create");
+        }
+        fiber_run(&sched);
+        ktest_assert(*(bool*)tls_get(flag_offset), "fiber did not write TLS");
+    }
+
+    return NULL;
+}
+
+void kernel_test(void) {
+    ktest_start("thread/tls");
+
+    errno_t err = tls_reserve(sizeof(per_thread_t), &per_thread_offset);
+    ktest_assert_errno(err, "tls_reserve(per_thread)");
+    err = tls_reserve(sizeof(bool), &flag_offset);
+    ktest_assert_errno(err, "tls_reserve(flag)");
+    ktest_assert(flag_offset >= per_thread_offset + sizeof(per_thread_t),
+            "TLS areas overlap");
+
+    size_t dummy;
+    err = tls_reserve(THREAD_TLS_SIZE, &dummy);
+    ktest_assert(err == ENOMEM, "TLS reservation over the limit");
+
+    thread_t* threads[THREAD_COUNT];
+    for (uintptr_t i = 0; i < THREAD_COUNT; i++) {
+        err = thread_create(&threads[i], worker, (void*)(i + 1), 0, "worker");
+        ktest_assert_errno(err, "thread_create");
+    }
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        err = thread_join(threads[i], NULL);
+        ktest_assert_errno(err, "thread_join");
+    }
+
+    ktest_passed();
+}
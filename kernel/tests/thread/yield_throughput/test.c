@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Benchmark of context switching. First, we ping-pong between the test and
+ * a hand-made context (no scheduler involved) using the full and the fast
+ * (callee-saved registers only) switch routine. Then we measure how many
+ * thread_yield() calls two threads can do per million cycles.
+ */
+
+#include <drivers/cp0.h>
+#include <ktest.h>
+#include <proc/context.h>
+#include <proc/thread.h>
+
+#define SWITCHES 1000
+#define YIELDS 1000
+#define PARTNER_STACK_SIZE 1024
+
+typedef void (*switch_func_t)(void**, void**, asid_t);
+
+static uint8_t partner_stack[PARTNER_STACK_SIZE] __attribute__((aligned(8)));
+static void* partner_stack_top;
+static void* test_stack_top;
+static switch_func_t volatile switch_func;
+
+static volatile bool terminate_partner = false;
+static volatile int partner_yields = 0;
+
+static void partner_context(void) {
+    while (true) {
+        switch_func(&partner_stack_top, &test_stack_top, 1);
+    }
+}
+
+static unative_t measure_switch(switch_func_t func) {
+    switch_func = func;
+
+    unative_t start = cp0_read_count();
+    for (int i = 0; i < SWITCHES; i++) {
+        switch_func(&test_stack_top, &partner_stack_top, 1);
+    }
+    // Each iteration switches there and back.
+    return (cp0_read_count() - start) / (2 * SWITCHES);
+}
+
+static void* yielding_partner(void* ignored) {
+    while (!terminate_partner) {
+        partner_yields++;
+        thread_yield();
+    }
+    return NULL;
+}
+
+void kernel_test(void) {
+    ktest_start("thread/yield_throughput");
+
+    context_t* context = (context_t*)(partner_stack + PARTNER_STACK_SIZE - sizeof(context_t));
+    context->ra = (unative_t)partner_context;
+    context->status = 0xff01;
+    partner_stack_top = context;
+
+    unative_t full = measure_switch(cpu_switch_context);
+    unative_t fast = measure_switch(cpu_switch_context_fast);
+    printk("cpu_switch_context: %u cycles/switch\n", full);
+    printk("cpu_switch_context_fast: %u cycles/switch\n", fast);
+    ktest_assert(fast <= full, "fast switch is slower than the full one");
+
+    thread_t* partner;
+    errno_t err = thread_create(&partner, yielding_partner, NULL, 0, "partner");
+    ktest_assert_errno(err, "thread_create");
+
+    unative_t start = cp0_read_count();
+    for (int i = 0; i < YIELDS; i++) {
+        thread_yield();
+    }
+    unative_t cycles = cp0_read_count() - start;
+    unative_t yields = YIELDS + partner_yields;
+
+    terminate_partner = true;
+    err = thread_join(partner, NULL);
+    ktest_assert_errno(err, "thread_join");
+
+    unsigned long long per_mcycle = (unsigned long long)yields * 1000000 / cycles;
+    printk("thread_yield: %u yields in %u cycles (%u yields/Mcycle)\n",
+            yields, cycles, (uint32_t)per_mcycle);
+
+    ktest_passed();
+}
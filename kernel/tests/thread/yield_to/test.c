@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Test of thread_yield_to(). Four threads (A-D) only record that they ran.
+ * Yielding to B must run B first, then the yielding thread runs in place
+ * of B, i.e. after A but before C and D.
+ */
+
+#include <ktest.h>
+#include <proc/thread.h>
+
+#define THREAD_COUNT 4
+
+static char order[THREAD_COUNT + 2];
+static volatile size_t order_length = 0;
+
+static void record(char id) {
+    order[order_length] = id;
+    order_length++;
+}
+
+static void* worker(void* arg) {
+    record((char)(uintptr_t)arg);
+    return NULL;
+}
+
+static void* suspended_worker(void* ignored) {
+    thread_suspend();
+    return NULL;
+}
+
+void kernel_test(void) {
+    ktest_start("thread/yield_to");
+
+    errno_t err;
+    thread_t* threads[THREAD_COUNT];
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        err = thread_create(&threads[i], worker, (void*)(uintptr_t)('A' + i), 0, "worker");
+        ktest_assert_errno(err, "thread_create");
+    }
+
+    err = thread_yield_to(threads[1]);
+    ktest_assert_errno(err, "thread_yield_to");
+    record('M');
+    ktest_assert(thread_yield_to(threads[0]) == EEXITED, "finished thread");
+
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        err = thread_join(threads[i], NULL);
+        ktest_assert_errno(err, "thread_join");
+    }
+    order[order_length] = '\0';
+
+    puts(KTEST_EXPECTED "BAMCD");
+    printk(KTEST_ACTUAL "%s\n", order);
+
+    err = thread_yield_to(thread_get_current());
+    ktest_assert_errno(err, "thread_yield_to(myself)");
+
+    thread_t* suspended;
+    err = thread_create(&suspended, suspended_worker, NULL, 0, "suspended");
+    ktest_assert_errno(err, "thread_create(suspended)");
+    thread_yield();
+    ktest_assert(thread_yield_to(suspended) == EINVAL, "suspended thread");
+    err = thread_wakeup(suspended);
+    ktest_assert_errno(err, "thread_wakeup");
+    err = thread_yield_to(suspended);
+    ktest_assert_errno(err, "thread_yield_to(woken)");
+    ktest_assert(thread_has_finished(suspended), "woken thread shall have run");
+    err = thread_join(suspended, NULL);
+    ktest_assert_errno(err, "thread_join(suspended)");
+
+    ktest_passed();
+}
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Checks scheduler tracing (the test is always compiled with KERNEL_TRACE):
+ * a sleeper suspends itself and is woken by a waker. The trace must
+ * contain these events in the right order with non-decreasing timestamps.
+ * The trace is dumped at the end for tools/trace.py.
+ */
+
+#include <debug/trace.h>
+#include <ktest.h>
+#include <proc/thread.h>
+
+#ifndef KERNEL_TRACE
+#error This test requires KERNEL_TRACE
+#endif
+
+static thread_t* sleeper_thread;
+
+static void* sleeper(void* ignored) {
+    thread_suspend();
+    return NULL;
+}
+
+static void* waker(void* ignored) {
+    while (!thread_has_finished(sleeper_thread)) {
+        thread_wakeup(sleeper_thread);
+        thread_yield();
+    }
+    return NULL;
+}
+
+/** Find first event of a thread at or after the given record index. */
+static size_t find_event(size_t start, trace_event_t event, unative_t thread_id) {
+    size_t count = trace_get_count();
+    for (size_t i = start; i < count; i++) {
+        trace_record_t* record = trace_get(i);
+        if ((record->event == event) && (record->thread_id == thread_id)) {
+            return i;
+        }
+    }
+    ktest_assert(false, "event %u of thread %u not found", event, thread_id);
+    return count;
+}
+
+static bool str_starts_with(const char* s, const char* prefix) {
+    while (*prefix != '\0') {
+        if (*s != *prefix) {
+            return false;
+        }
+        s++;
+        prefix++;
+    }
+    return true;
+}
+
+void kernel_test(void) {
+    ktest_start("trace/basic");
+
+    trace_reset();
+    ktest_assert(trace_get_count() == 0, "trace not empty after reset");
+
+    thread_t* threads[2];
+    errno_t err = thread_create(&threads[0], sleeper, NULL, 0, "sleeper");
+    ktest_assert_errno(err, "thread_create(sleeper)");
+    sleeper_thread = threads[0];
+    err = thread_create(&threads[1], waker, NULL, 0, "waker");
+    ktest_assert_errno(err, "thread_create(waker)");
+
+    unative_t sleeper_id = threads[0]->id;
+    unative_t waker_id = threads[1]->id;
+
+    err = thread_join(threads[1], NULL);
+    ktest_assert_errno(err, "thread_join(waker)");
+    err = thread_join(threads[0], NULL);
+    ktest_assert_errno(err, "thread_join(sleeper)");
+
+    size_t created = find_event(0, TRACE_CREATE, sleeper_id);
+    size_t in = find_event(created, TRACE_SWITCH_IN, sleeper_id);
+    size_t suspended = find_event(in, TRACE_SUSPEND, sleeper_id);
+    size_t out = find_event(suspended, TRACE_SWITCH_OUT, sleeper_id);
+    size_t woken = find_event(out, TRACE_WAKEUP, sleeper_id);
+    ktest_assert(trace_get(woken)->arg == waker_id, "woken by %u", trace_get(woken)->arg);
+    size_t in_again = find_event(woken, TRACE_SWITCH_IN, sleeper_id);
+    find_event(in_again, TRACE_FINISH, sleeper_id);
+
+    size_t count = trace_get_count();
+    for (size_t i = 1; i < count; i++) {
+        unative_t delta = trace_get(i)->timestamp - trace_get(i - 1)->timestamp;
+        ktest_assert(delta < 0x80000000, "timestamps going back at %u", i);
+    }
+
+    // The same dump formatted into memory (only its beginning fits).
+    char head[16];
+    print_buffer_sink_t sink;
+    print_buffer_sink_init(&sink, head, sizeof(head));
+    trace_dump_to(&sink.base);
+    print_buffer_sink_terminate(&sink);
+    ktest_assert(sink.base.length > sizeof(head), "dump has only %u characters", sink.base.length);
+    ktest_assert(str_starts_with(head, "[trace] begin "), "dump starts with %s", head);
+
+    trace_dump();
+
+    ktest_passed();
+}
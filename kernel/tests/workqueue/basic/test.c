@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Submits more work than fits into the queue (so that the submitter has to
+ * wait) and checks that each work item was executed exactly once and that
+ * work_wait returns only after all of them finished. Then fills the queue
+ * without letting the workers run and checks that destroy finishes it.
+ */
+
+#include <ktest.h>
+#include <proc/thread.h>
+#include <proc/workqueue.h>
+
+#define WORKERS 3
+#define CAPACITY 4
+#define ITEMS 100
+
+static volatile int executed[ITEMS];
+static volatile int running = 0;
+
+static void work(void* arg) {
+    uintptr_t index = (uintptr_t)arg;
+    running++;
+    // Let other workers run so that work really overlaps.
+    thread_yield();
+    executed[index]++;
+    running--;
+}
+
+void kernel_test(void) {
+    ktest_start("workqueue/basic");
+
+    workqueue_t* wq;
+    errno_t err = workqueue_create(&wq, 0, CAPACITY, 0);
+    ktest_assert(err == EINVAL, "no workers accepted");
+    err = workqueue_create(&wq, WORKERS, CAPACITY, THREAD_FLAG_STACK_SMALL);
+    ktest_assert_errno(err, "workqueue_create");
+
+    for (uintptr_t i = 0; i < ITEMS; i++) {
+        work_submit(wq, work, (void*)i);
+    }
+
+    work_wait(wq);
+    ktest_assert(running == 0, "work_wait returned with %d work running", running);
+    for (int i = 0; i < ITEMS; i++) {
+        ktest_assert(executed[i] == 1, "item %d executed %d times", i, executed[i]);
+    }
+
+    // Workers do not run until we yield, so the queue fills up.
+    for (uintptr_t i = 0; i < CAPACITY; i++) {
+        err = work_try_submit(wq, work, (void*)i);
+        ktest_assert_errno(err, "work_try_submit");
+    }
+    ktest_assert(work_try_submit(wq, work, (void*)0) == EBUSY, "full queue accepted work");
+
+    workqueue_destroy(wq);
+    for (int i = 0; i < CAPACITY; i++) {
+        ktest_assert(executed[i] == 2, "work %d was not finished by destroy", i);
+    }
+
+    ktest_passed();
+}
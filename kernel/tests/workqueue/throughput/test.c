@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: Apache-2.0
+// Copyright 2019 Charles University
+
+/*
+ * Benchmark of executing short tasks: first each task gets its own thread
+ * (created and joined in batches), then the same tasks are submitted to
+ * a work queue with the same number of workers.
+ *
+ * The test only checks that all tasks were executed, the cycle counts are
+ * printed for comparison.
+ */
+
+#include <drivers/cp0.h>
+#include <ktest.h>
+#include <proc/thread.h>
+#include <proc/workqueue.h>
+
+#define TASKS 1000
+#define PARALLELISM 4
+
+static volatile unative_t sum = 0;
+
+static void task(void* arg) {
+    sum += (uintptr_t)arg;
+}
+
+static void* task_thread(void* arg) {
+    task(arg);
+    return NULL;
+}
+
+static void report(const char* name, unative_t cycles) {
+    printk("%s: %u tasks in %u cycles (%u cycles/task, %u tasks/Mcycle)\n",
+            name, TASKS, cycles, cycles / TASKS, TASKS * 1000000 / cycles);
+}
+
+void kernel_test(void) {
+    ktest_start("workqueue/throughput");
+
+    unative_t expected = TASKS * (TASKS + 1) / 2;
+    errno_t err;
+
+    unative_t start = cp0_read_count();
+    for (uintptr_t i = 1; i <= TASKS; i += PARALLELISM) {
+        thread_t* threads[PARALLELISM];
+        for (uintptr_t j = 0; j < PARALLELISM; j++) {
+            err = thread_create(&threads[j], task_thread, (void*)(i + j), 0, "task");
+            ktest_assert_errno(err, "thread_create");
+        }
+        for (uintptr_t j = 0; j < PARALLELISM; j++) {
+            err = thread_join(threads[j], NULL);
+            ktest_assert_errno(err, "thread_join");
+        }
+    }
+    report("thread-per-task", cp0_read_count() - start);
+    ktest_assert(sum == expected, "thread sum %u != %u", sum, expected);
+
+    sum = 0;
+    start = cp0_read_count();
+    workqueue_t* wq;
+    err = workqueue_create(&wq, PARALLELISM, PARALLELISM * 2, 0);
+    ktest_assert_errno(err, "workqueue_create");
+    for (uintptr_t i = 1; i <= TASKS; i++) {
+        work_submit(wq, task, (void*)i);
+    }
+    work_wait(wq);
+    report("workqueue", cp0_read_count() - start);
+    workqueue_destroy(wq);
+    ktest_assert(sum == expected, "workqueue sum %u != %u", sum, expected);
+
+    ktest_passed();
+}
@@ -5,6 +5,7 @@
 
 
 import argparse
+import json
 import logging
 import multiprocessing
 import os
@@ -17,6 +18,9 @@ import time
 
 CPU_COUNT = multiprocessing.cpu_count()
 
+# Keep in sync with KBENCH_RESULT in kernel/include/kbench.h.
+KBENCH_RESULT_RE = re.compile(r'^\[ KBENCH \]: (\S+)((?: \w+=\d+)+)$')
+
 
 class TesterException(Exception):
     def __init__(self, message, details):
@@ -187,6 +191,30 @@ def run_kernel_test(test_descriptor, extra_arguments):
     if exit_code != 0:
         raise TesterException('test failed', 'see report.log')
 
+    return output
+
+def parse_bench_results(output):
+    results = []
+    for line in output:
+        match = KBENCH_RESULT_RE.match(line)
+        if match is None:
+            continue
+        result = {
+            'name': match.group(1),
+        }
+        for pair in match.group(2).split():
+            (key, value) = pair.split('=')
+            result[key] = int(value)
+        results.append(result)
+    return results
+
+def run_bench_test(test_descriptor, extra_arguments):
+    output = run_kernel_test(test_descriptor, extra_arguments)
+    results = parse_bench_results(output)
+    if not results:
+        raise TesterException('no benchmark results', 'see msim.log')
+    return results
+
 def get_suite_tests(suite_filename):
     with open(suite_filename, 'r') as suite:
         for line in suite:
@@ -212,6 +240,13 @@ def run_tests(tests, extra_arguments):
                     'name': test['name'],
                     'status': 'passed'
                 })
+            elif test['type'] == 'bench':
+                results = run_bench_test(test['name'], extra_arguments)
+                report.append({
+                    'name': test['name'],
+                    'status': 'passed',
+                    'benchmarks': results,
+                })
             else:
                 raise TesterException('unknown test type {} for {}'.format(
                     test['type'], test['name']), '')
@@ -242,6 +277,9 @@ def print_report(report):
     for result in report:
         if result['status'] == 'passed':
             logger.info(' - %s passed', result['name'])
+            for bench in result.get('benchmarks', []):
+                logger.info('     %-32s min %8d  median %8d  max %8d cycles',
+                            bench['name'], bench['min'], bench['median'], bench['max'])
             count_passed = count_passed + 1
         elif result['status'] == 'failed':
             logger.info(' - %s FAILED (%s)', result['name'], result['message'])
@@ -258,6 +296,15 @@ def print_report(report):
         logger.info('There were failures: %d passed, %d failed.', count_passed, count_failures)
 
 
+def write_json_report(report, filename):
+    with open(filename, 'wt') as f:
+        json.dump({
+            'unit': 'cycles',
+            'tests': report,
+        }, f, indent=4)
+        f.write('\n')
+
+
 def main():
     common_args = argparse.ArgumentParser(add_help=False)
     common_args.add_argument('--verbose',
@@ -269,6 +316,11 @@ def main():
                              default=None,
                              dest='toolchain_dir',
                              help='Toolchain directory.')
+    common_args.add_argument('--json-report',
+                             default=None,
+                             dest='json_report',
+                             metavar='FILENAME',
+                             help='Store the report (with benchmark results) as JSON.')
 
     args = argparse.ArgumentParser(description='Run NSWI004 tests')
     args.set_defaults(action='help')
@@ -285,6 +337,13 @@ def main():
                              nargs='+',
                              help='Kernel test names.')
 
+    args_bench = args_sub.add_parser('bench', help='Run kernel benchmark.', parents=[common_args])
+    args_bench.set_defaults(action='bench')
+    args_bench.add_argument('test_names',
+                            metavar='TEST_NAME',
+                            nargs='+',
+                            help='Kernel benchmark names.')
+
     args_suite = args_sub.add_parser('suite', help='Run whole test suite.', parents=[common_args])
     args_suite.set_defaults(action='suite')
     args_suite.add_argument('suite_files',
@@ -317,10 +376,10 @@ def main():
         extra_arguments['configure'].append(os.path.realpath(config.toolchain_dir))
 
     tests = []
-    if config.action == 'kernel':
+    if config.action in ['kernel', 'bench']:
         for test in config.test_names:
             tests.append({
-                'type': 'kernel',
+                'type': config.action,
                 'name': test
             })
     elif config.action == 'suite':
@@ -336,6 +395,8 @@ def main():
     report = run_tests(tests, extra_arguments)
 
     print_report(report)
+    if config.json_report is not None:
+        write_json_report(report, config.json_report)
 
     return 0 if all_tests_passed(report) else 1
 
@@ -0,0 +1,180 @@
+#!/usr/bin/python3
+
+# SPDX-License-Identifier: Apache-2.0
+# Copyright 2019 Charles University
+
+"""
+Summarize scheduler trace dumped by trace_dump() (kernel built with --trace).
+
+Reads console output (e.g. msim.log) from given file or standard input and
+prints per-thread run time, number of switches and wake-up latency (time
+from TRACE_WAKEUP to the following TRACE_SWITCH_IN of the same thread).
+All times are in CP0 Count cycles.
+"""
+
+import argparse
+import sys
+
+PREFIX = '[trace] '
+COUNTER_MODULO = 2 ** 32
+
+THREAD_STATES = ['READY', 'SUSPENDED', 'FINISHED']
+
+
+def print_error(fmt, *args, **kwargs):
+    print(fmt.format(*args, **kwargs), file=sys.stderr)
+
+
+class ThreadStats:
+    def __init__(self, thread_id):
+        self.thread_id = thread_id
+        self.name = '?'
+        self.run_time = 0
+        self.switches_in = 0
+        self.suspends = 0
+        self.wakeups = 0
+        self.latencies = []
+        self.running_since = None
+        self.woken_at = None
+
+
+class Trace:
+    def __init__(self):
+        self.records = []
+        self.names = {}
+        self.dropped = 0
+
+    def parse(self, lines):
+        inside = False
+        for line_number, line in enumerate(lines, 1):
+            line = line.rstrip()
+            if not line.startswith(PREFIX):
+                continue
+            parts = line[len(PREFIX):].split()
+            if parts[0] == 'begin':
+                # Keep only the last dump.
+                self.records = []
+                self.names = {}
+                self.dropped = int(parts[2])
+                inside = True
+            elif parts[0] == 'end':
+                inside = False
+            elif not inside:
+                print_error('Line {}: trace record outside of a dump.', line_number)
+            elif parts[0] == 'thread':
+                self.names[int(parts[1])] = ' '.join(parts[2:])
+            else:
+                self.records.append((int(parts[0]), parts[1], int(parts[2]), int(parts[3])))
+
+    def get_stats(self):
+        stats = {}
+
+        def get(thread_id):
+            if thread_id not in stats:
+                stats[thread_id] = ThreadStats(thread_id)
+                stats[thread_id].name = self.names.get(thread_id, '?')
+            return stats[thread_id]
+
+        for timestamp, event, thread_id, arg in self.records:
+            thread = get(thread_id)
+            if event == 'in':
+                thread.switches_in += 1
+                thread.running_since = timestamp
+                if thread.woken_at is not None:
+                    thread.latencies.append((timestamp - thread.woken_at) % COUNTER_MODULO)
+                    thread.woken_at = None
+            elif event == 'out':
+                if thread.running_since is not None:
+                    thread.run_time += (timestamp - thread.running_since) % COUNTER_MODULO
+                    thread.running_since = None
+            elif event == 'suspend':
+                thread.suspends += 1
+            elif event == 'wakeup':
+                thread.wakeups += 1
+                thread.woken_at = timestamp
+
+        return sorted(stats.values(), key=lambda t: t.run_time, reverse=True)
+
+    def get_duration(self):
+        # Sum of the deltas so that the trace may span more than one
+        # wrap-around of the counter.
+        duration = 0
+        for previous, current in zip(self.records, self.records[1:]):
+            duration += (current[0] - previous[0]) % COUNTER_MODULO
+        return duration
+
+
+def print_summary(trace):
+    duration = trace.get_duration()
+    print('{} records over {} cycles ({} older records were overwritten).'.format(
+        len(trace.records), duration, trace.dropped))
+    print()
+    print('{:>5} {:<20} {:>12} {:>6} {:>8} {:>8} {:>8} {:>10} {:>10}'.format(
+        'id', 'name', 'run time', 'share', 'switches', 'blocked', 'wakeups',
+        'lat. avg', 'lat. max'))
+    for thread in trace.get_stats():
+        share = 100.0 * thread.run_time / duration if duration > 0 else 0
+        if thread.latencies:
+            latency_avg = sum(thread.latencies) // len(thread.latencies)
+            latency_max = max(thread.latencies)
+        else:
+            latency_avg = latency_max = '-'
+        print('{:>5} {:<20} {:>12} {:>5.1f}% {:>8} {:>8} {:>8} {:>10} {:>10}'.format(
+            thread.thread_id, thread.name[:20], thread.run_time, share,
+            thread.switches_in, thread.suspends, thread.wakeups,
+            latency_avg, latency_max))
+
+
+def print_timeline(trace):
+    if not trace.records:
+        return
+    start = trace.records[0][0]
+    for timestamp, event, thread_id, arg in trace.records:
+        name = trace.names.get(thread_id, '?')
+        if event == 'out':
+            detail = THREAD_STATES[arg] if arg < len(THREAD_STATES) else str(arg)
+        elif event == 'in':
+            detail = 'after {}'.format(arg) if arg != 0 else ''
+        elif event == 'wakeup' or event == 'create':
+            detail = 'by {}'.format(arg) if arg != 0 else ''
+        else:
+            detail = ''
+        print('{:>12} {:<8} {:>5} {:<20} {}'.format(
+            (timestamp - start) % COUNTER_MODULO, event, thread_id, name[:20], detail))
+
+
+def main():
+    args = argparse.ArgumentParser(description='Scheduler trace analyzer')
+    args.add_argument('--timeline',
+        default=False,
+        dest='timeline',
+        action='store_true',
+        help='Print all events instead of the summary.'
+    )
+    args.add_argument('log',
+        nargs='?',
+        default=None,
+        help='Console output with the trace dump (default is stdin).'
+    )
+    config = args.parse_args()
+
+    trace = Trace()
+    if config.log is None:
+        trace.parse(sys.stdin)
+    else:
+        with open(config.log, 'rt') as f:
+            trace.parse(f)
+
+    if not trace.records:
+        print_error('No trace found (was the kernel configured with --trace?).')
+        return 1
+
+    if config.timeline:
+        print_timeline(trace)
+    else:
+        print_summary(trace)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())